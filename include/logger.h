@@ -21,6 +21,8 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
+
 #if defined(WIN32) || defined(_WIN32) || defined(_WIN64) && !defined(__CYGWIN__)
 #define WIN 1
 #include "time.h"
@@ -29,26 +31,33 @@ extern "C" {
 #include "sys/time.h"
 #endif
 
-// Helper defines to generate TAGs
+// Helper defines to generate TAGs. The enum constants are the tags, so they can be used in switch cases and static
+// initializers. makeLoggerDef() registers them with their names in the tag registry. Use GENERATE_DEF once per
+// program, plugins register their tags with logger_registerTag, which hands out the tags after the enum.
 #define GENERATE_ENUM(ENUM) ENUM##_START, ENUM##_END,
 #define GENERATE_EVALLIST(ENUM) {ENUM##_START, ENUM##_END},
 #define GENERATE_STRING(STRING) #STRING
 #define GENERATE_TAGSTRINGS(TAG) GENERATE_STRING(TAG##_START), GENERATE_STRING(TAG##_END),
-#define GENERATE_DEF(TAGS)                                                  \
-    enum TAG_ENUM { TAGS(GENERATE_ENUM) TAG_COUNT };                        \
-    static const char *TAG_STRING[] = {TAGS(GENERATE_TAGSTRINGS)};          \
-    logger_tagDef_t *makeLoggerDef() {                                      \
-        logger_tagDef_t *def = malloc(sizeof(logger_tagDef_t) * TAG_COUNT); \
-        for (int i = 0; i < TAG_COUNT; i++) {                               \
-            def[i].tag = i;                                                 \
-            strcpy(def[i].info, TAG_STRING[i]);                             \
-        }                                                                   \
-        return def;                                                         \
-    }                                                                       \
-    logger_tagPair_t evalListFull[] = {TAGS(GENERATE_EVALLIST)};            \
+#define GENERATE_DEF(TAGS)                                                                     \
+    enum TAG_ENUM { TAGS(GENERATE_ENUM) TAG_COUNT };                                           \
+    static const char *TAG_STRING[] = {TAGS(GENERATE_TAGSTRINGS)};                             \
+    logger_tagDef_t *makeLoggerDef() {                                                         \
+        logger_tagDef_t *def = (logger_tagDef_t *)malloc(sizeof(logger_tagDef_t) * TAG_COUNT); \
+        for (int i = 0; i < TAG_COUNT; i++) {                                                  \
+            def[i].tag = i;                                                                    \
+            strcpy(def[i].info, TAG_STRING[i]);                                                \
+            logger_registerTagWithId(i, TAG_STRING[i]);                                        \
+        }                                                                                      \
+        return def;                                                                            \
+    }                                                                                          \
+    logger_tagPair_t evalListFull[] = {TAGS(GENERATE_EVALLIST)};                               \
     int evalListFullSize = sizeof(evalListFull) / 2 / sizeof(enum TAG_ENUM);
 
 #define LOGGER_TAG_INFO_MAXLEN 30
+// Highest tag of the tag registry.
+#define LOGGER_TAG_MAX 65535
+// Size in bytes of one block of a compressed list.
+#define LOGGER_BLOCK_SIZE 256
 
 // Type define for a Tag.
 typedef int logger_logTag_t;
@@ -57,12 +66,16 @@ typedef int logger_logTag_t;
  * A log entry consists of a tag, an id, and a timestamp.
  * @property {logger_logTag_t} tag - This is a tag to differentiate between
  * different log points.
+ * @property {int} cpu - The CPU the probe ran on or -1, when `recordCpu` is not set. On LP64 targets (64 bit Linux and
+ * macOS) it uses the padding after the tag and an entry keeps its 32 bytes. On LLP64 (64 bit Windows) it adds 8 bytes
+ * and on 32 bit targets 4 to 8 bytes per entry of a LLIST_PLAIN list.
  * @property {unsigned long} id - This is a unique id for each log entry. It is
  * used to identify multiple runs of the same tag.
  * @property time_stamp - The timestamp of the log entry.
  */
 typedef struct {
     logger_logTag_t tag;
+    int cpu;
     unsigned long id;
     struct timespec time_stamp;
 } logger_logEntry_t;
@@ -108,19 +121,48 @@ typedef enum {
 } logger_clockType_t;
 
 /**
- * `logger_config_t` is a struct to configure the logger while initialization.
+ * The storage mode of the log lists.
+ * LLIST_PLAIN stores each entry as a `logger_logEntry_t`.
+ * LLIST_COMPRESSED stores the entries delta encoded in blocks of LOGGER_BLOCK_SIZE bytes. Writing an entry takes a
+ * bounded time, but the entries can only be read back by the export and evaluate functions.
+ * LLIST_RING stores each entry as a `logger_logEntry_t`, but overwrites the oldest entries when a list is full. Use it
+ * together with `logger_addOutlierRecorder` to run without keeping a full capture.
+ */
+typedef enum { LLIST_PLAIN = 0, LLIST_COMPRESSED, LLIST_RING } logger_listMode_t;
+
+/**
+ * `logger_config_t` is a struct to configure the logger while initialization. Zero-initialize it, so that new options
+ * keep their default. `logger_init` rejects a config with an unknown listMode or a recordCpu other than 0 and 1.
  * @property {logger_clockType_t} clockType - The type of clock to use for the
  * logger.
  * @property {int} listCount - The number of list. You can use different list e.g. for each thread in a multithreaded
  * environment.
- * @property {int} listSize - The size of each list. This is the maximum count of tags per list.
+ * @property {int} listSize - The size of each list. This is the maximum count of tags per list. In LLIST_COMPRESSED
+ * mode it is the count of LOGGER_BLOCK_SIZE byte blocks per list.
+ * @property {logger_listMode_t} listMode - The storage mode of the lists. Default is LLIST_PLAIN.
+ * @property {int} recordCpu - 1 records the CPU of every entry, e.g. to find spans that migrated between CPUs. With
+ * LCLOCK_RDTSCP the CPU is taken from the same rdtscp instruction, otherwise from sched_getcpu() or
+ * GetCurrentProcessorNumber(). Default is 0.
  */
 typedef struct {
     logger_clockType_t clockType;
     int listCount;
     int listSize;
+    logger_listMode_t listMode;
+    int recordCpu;
 } logger_config_t;
 
+/**
+ * The sampling modes of a tag pair.
+ * LSAMPLE_ALL records every probe.
+ * LSAMPLE_ONE_IN_N records about one in N spans. The decision is made by a hash of the id, so the START and END
+ * entries of the same id are always kept together. The ids of a tag pair should be distinct per run.
+ * LSAMPLE_PERIOD records at most one span per period and list. It keeps the first START after the period elapsed and
+ * the END with the same id in the same list. No START is kept while that span is open. The START probes of this mode
+ * always read the clock.
+ */
+typedef enum { LSAMPLE_ALL = 0, LSAMPLE_ONE_IN_N, LSAMPLE_PERIOD } logger_sampleMode_t;
+
 // Realtime safe functions with very small performance impact
 //------------------------------------------------------------------------------------------------------------------
 /**
@@ -133,7 +175,7 @@ typedef struct {
  * used to identify multiple runs of the same tag.
  * @param listNumber The number of the list to add the entry to.
  *
- * @return 0=success;-1=list not found;-2=list overflow
+ * @return 0=success;1=skipped by sampling;-1=list not found;-2=list overflow
  */
 int logger_addLogEntry(logger_logTag_t tag, long id, int listNumber);
 /**
@@ -147,38 +189,114 @@ int logger_addLogEntry(logger_logTag_t tag, long id, int listNumber);
  * @param listNumber The number of the list to add the entry to.
  * @param time The time of the event.
  *
- * @return 0=success;-1=list not found;-2=list overflow
+ * @return 0=success;1=skipped by sampling;-1=list not found;-2=list overflow
  */
 int logger_addLogEntryCustTime(logger_logTag_t tag, long id, int listNumber, struct timespec time);
 
 // Non real-time safe functions. They are used to set up the logger and save the results. You must call them after using
 //------------------------------------------------------------------------------------------------------------------
 /**
- * Initialize the logger. Use the conf to configure the logger.It allocates memory for the logger.
+ * > Registers a tag name in the tag registry of the logger and returns its tag. Registering a known name returns the
+ * known tag, so plugins can register their tags without colliding with other tags. The export and evaluate functions
+ * use the registry for all tags not given in their logDef. The registry is kept by `logger_clear` and freed by
+ * `logger_freeTags`.
+ *
+ * @param name The name of the tag. It is copied.
+ *
+ * @return The tag or -1 on error.
+ */
+logger_logTag_t logger_registerTag(const char *name);
+/**
+ * > Registers a tag name with a fixed tag, e.g. a value of a compile-time enum. Register fixed tags before calling
+ * `logger_registerTag`, which hands out the tags after the highest registered tag.
+ *
+ * @param tag The tag, 0 to LOGGER_TAG_MAX.
+ * @param name The name of the tag. It is copied.
+ *
+ * @return 0=success;-1=tag out of range or tag or name already registered differently
+ */
+int logger_registerTagWithId(logger_logTag_t tag, const char *name);
+/**
+ * > Looks up a tag by its name in O(1).
+ *
+ * @return The tag or -1 when the name is not registered.
+ */
+logger_logTag_t logger_findTag(const char *name);
+/**
+ * > Returns the registered name of a tag in O(1).
+ *
+ * @return The name or NULL when the tag is not registered.
+ */
+const char *logger_getTagName(logger_logTag_t tag);
+/**
+ * > Frees the tag registry. All registered tags are forgotten, so register them again before the next use. Call it
+ * once the logger is not used anymore, e.g. after the last `logger_clear`.
+ */
+void logger_freeTags();
+/**
+ * Initialize the logger. Use the conf to configure the logger.It allocates memory for the logger and pins it.
+ * The config must be zero-initialized, since listMode and recordCpu were added. A config that is declared without an
+ * initializer has random values in them and is rejected.
  *
  * @param conf the configuration of the logger
  *
- * @return 0=success;else=error
+ * @return 0=success;1=the memory could not be pinned, the logger works anyway;-1=invalid config;-3=could not allocate
+ * the lists
  */
 int logger_init(logger_config_t conf);
 /**
- * > Write the content of the log lists to a CSV file
+ * > Configures the sampling of a tag pair. Skipped probes return before the clock is read, except for the START
+ * probes in LSAMPLE_PERIOD mode. `logger_evaluate` corrects the count and rate by the measured sampling factor. The
+ * sampling state is kept per list. Call it after `logger_init` and not while probes are running, since it reallocates
+ * the state.
+ *
+ * @param pair The tag pair to sample.
+ * @param mode The sampling mode. LSAMPLE_ALL disables the sampling.
+ * @param param N for LSAMPLE_ONE_IN_N, the period in nanoseconds for LSAMPLE_PERIOD.
+ *
+ * @return 0=success;-1=invalid tag or not initialized
+ */
+int logger_setSampling(logger_tagPair_t pair, logger_sampleMode_t mode, unsigned long param);
+/**
+ * > Adds an outlier recorder for a tag pair. It keeps the k longest spans in a fixed-size min-heap. For each of them
+ * the entries of all lists in [start - windowNs, end + windowNs] are copied to a preallocated side buffer of
+ * contextSize entries, which is split over the lists. When a list has more entries in the window than its share, the
+ * entries nearest to the start and the end of the window are kept. The copy is made by a probe of the pair after the
+ * window has passed, at most one copy per probe. Plain and ring lists are searched by binary search. Compressed lists
+ * are searched by block, and the blocks of the window are decoded. The entries of a list are expected in time order.
+ * Lists of other threads are read while they are written, entries that are overwritten during the copy are dropped.
+ * All memory is allocated and pinned here. A recorder tracks up to 64 open spans, further START entries are dropped
+ * and reported. It should be fed from one thread. Call it after `logger_init` and not while probes are running.
+ *
+ * @param pair The tag pair to record.
+ * @param k The count of spans to keep.
+ * @param windowNs The time window in nanoseconds before and after a span to keep as context.
+ * @param contextSize The maximum count of context entries per span.
+ *
+ * @return 0=success;-1=invalid parameter
+ */
+int logger_addOutlierRecorder(logger_tagPair_t pair, int k, int64_t windowNs, int contextSize);
+/**
+ * > Write the content of the log lists to a CSV file. The first line holds the metadata of the export, e.g.
+ * `#rtperflog;version=1;clock=1;base_sec=5321;pid=4711`. The timestamps are relative to base_sec of the clock. With
+ * recordCpu every row has the CPU as fourth column.
  *
  * @param fileName The name of the file to write to.
- * @param logDef This is a pointer to an array of logger_tagDef_t structures.
+ * @param logDef This is a pointer to an array of logger_tagDef_t structures. If NULL, the tag registry is used.
  * @param logDefCount The number of tags in the logDef array.
  *
  * @return 0=success;-2=file error;
  */
 int logger_writeToCSV(const char *fileName, logger_tagDef_t *logDef, int logDefCount);
 /**
- * It writes the log entries of a specific log list to a CSV file
+ * It writes the log entries of a specific log list to a CSV file. The first line holds the metadata of the export, as
+ * described at `logger_writeToCSV`.
  *
  * @param fileName The name of the file to write to.
  * @param exportList Array of list numbers that should be exported. If NULL,
  * all lists will be exported.
  * @param exportListCount The number of lists to export in exportList.
- * @param logDef This is a pointer to an array of logger_tagDef_t structures.
+ * @param logDef This is a pointer to an array of logger_tagDef_t structures. If NULL, the tag registry is used.
  * @param logDefCount The number of log definitions in logDef
  *
  * @return 0=success;-1=list not found;-2=file error;
@@ -186,13 +304,31 @@ int logger_writeToCSV(const char *fileName, logger_tagDef_t *logDef, int logDefC
 int logger_writeListToCSV(const char *fileName, int *listIds, int listIdsCount, logger_tagDef_t *logDef,
                           int logDefCount);
 
+/**
+ * > Writes the content of all log lists to a binary capture. In contrast to the CSV export the absolute timestamps
+ * and the list numbers are kept. The capture can be read by the rtperflog tools.
+ *
+ * @param fileName The name of the file to write to.
+ * @param logDef This is a pointer to an array of logger_tagDef_t structures. If NULL, the tag registry is used.
+ * @param logDefCount The number of tags in the logDef array.
+ *
+ * @return 0=success;-1=list not found;-2=file error;
+ */
+int logger_writeToBinary(const char *fileName, logger_tagDef_t *logDef, int logDefCount);
+
 /**
  * It takes a list of tag pairs and a list of tag definitions and exports out the
- * min, max, mean and median of the time difference between the tags
+ * min, max, mean and median of the time difference between the tags. When sampling is configured, the sampling factor,
+ * the estimated count of all spans and the estimated span rate are exported as well (CSV columns
+ * SAMPLING;EST_COUNT;RATE). With recordCpu the count of spans that migrated between CPUs is added (column MIGRATED),
+ * and a second CSV table TAGS;CPU;COUNT;MIN;MAX;AVG;MIGRATED follows after a blank line, with one row per pair and CPU
+ * of the START entry. The JSON output has the keys sampling, est_count, rate, migrated and cpus under the same
+ * conditions.
  *
  * @param pairList A list of tag pairs to evaluate.
  * @param pairListCount The number of pairs of tags to evaluate.
- * @param logDef This is a list of all the tag meta definitions that you want to evaluate.
+ * @param logDef This is a list of all the tag meta definitions that you want to evaluate. If NULL, the tag registry
+ * is used.
  * @param logDefCount The number of tag definitions.
  * @param csv_filename The name of the file to write the results to in CSV format.
  * @param json_filename The name of the file to write the results to in JSON format. If csv_filename and json_filename
@@ -205,11 +341,13 @@ int logger_evaluate(logger_tagPair_t *pairList, int pairListCount, logger_tagDef
 
 /**
  * It takes a list of tag pairs and a list of tag definitions and exports the
- * time difference between each pair of tags
+ * time difference between each pair of tags. With recordCpu every span gets the CPUs of its START and END entry and a
+ * flag, whether it migrated (CSV columns START_CPU;END_CPU;MIGRATED).
  *
  * @param pairList  A list of tag pairs to evaluate.
  * @param pairListCount The number of pairs of tags to evaluate
- * @param logDef This is a list of all the tag meta definitions you want to evaluate.
+ * @param logDef This is a list of all the tag meta definitions you want to evaluate. If NULL, the tag registry is
+ * used.
  * @param logDefCount The number of tag definitions in the logDef array.
  * @param csv_filename The name of the file to write the results to. If NULL,
  * the results will be printed to the console.
@@ -219,6 +357,45 @@ int logger_evaluate(logger_tagPair_t *pairList, int pairListCount, logger_tagDef
 int logger_evaluate_diff(logger_tagPair_t *pairList, int pairListCount, logger_tagDef_t *logDef, int logDefCount,
                          const char *csv_filename);
 
+/**
+ * > Evaluates the tag pairs over time. The spans are bucketed by their start time into windows of windowNs, which are
+ * aligned to multiples of windowNs of the clock. For each window with spans the count, min, max, p50 and p99 are
+ * written as a time series; windows without spans are left out. WALL_START is the window start on the wall clock
+ * (Unix time), using the offset between the clock of the logger and the wall clock at the time of the evaluation. It
+ * is empty for clocks without a fixed offset (LCLOCK_RDTSCP). The evaluation takes one pass over the entries of all
+ * lists in time order, so a START entry is matched with the next END entry of its id in any list. The memory use
+ * grows with the count of windows with spans, the quantiles are taken from a histogram with a relative error below
+ * 1.6%.
+ *
+ * @param pairList A list of tag pairs to evaluate.
+ * @param pairListCount The number of pairs of tags to evaluate
+ * @param windowNs The length of a window in nanoseconds.
+ * @param logDef This is a list of all the tag meta definitions you want to evaluate. If NULL, the tag registry is
+ * used.
+ * @param logDefCount The number of tag definitions in the logDef array.
+ * @param csv_filename The name of the file to write the time series to in CSV format.
+ * @param json_filename The name of the file to write the time series to in JSON format. If csv_filename and
+ * json_filename are NULL, the results will be printed to the console.
+ *
+ * @return 0=success;-1=invalid window;-2=could not open file
+ */
+int logger_evaluate_windowed(logger_tagPair_t *pairList, int pairListCount, int64_t windowNs,
+                             logger_tagDef_t *logDef, int logDefCount, const char *csv_filename,
+                             const char *json_filename);
+
+/**
+ * > Writes the spans of all outlier recorders, longest first, followed by their context entries. The context offsets
+ * are relative to the span start in milliseconds. A DROPPED row counts the START entries of a recorder that were
+ * dropped, because more than 64 spans were open.
+ *
+ * @param fileName The name of the file to write to. If NULL, the report is printed to the console.
+ * @param logDef This is a pointer to an array of logger_tagDef_t structures. If NULL, the tag registry is used.
+ * @param logDefCount The number of tags in the logDef array.
+ *
+ * @return 0=success;-2=file error;
+ */
+int logger_writeOutlierReport(const char *fileName, logger_tagDef_t *logDef, int logDefCount);
+
 /**
  * > Returns the count of errors while trying to wirte to the log list.
  *
@@ -226,6 +403,25 @@ int logger_evaluate_diff(logger_tagPair_t *pairList, int pairListCount, logger_t
  */
 int *logger_getErrorCount();
 
+/**
+ * > Returns the count of entries in a list.
+ *
+ * @param listNumber The number of the list.
+ *
+ * @return The count of entries or -1 when the list is not found.
+ */
+int logger_getEntryCount(int listNumber);
+
+/**
+ * > Returns the memory in bytes used by the entries of a list. Together with `logger_getEntryCount` it can be used to
+ * calculate the compression ratio of LLIST_COMPRESSED lists.
+ *
+ * @param listNumber The number of the list.
+ *
+ * @return The used bytes or -1 when the list is not found.
+ */
+long logger_getListMemUsage(int listNumber);
+
 /**
  * Resets the logger without freeing the memory.
  */
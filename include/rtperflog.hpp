@@ -0,0 +1,140 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains the header-only C++ API for the logger. Define RTPERFLOG_DISABLE to remove all
+ * probes at compile time.
+ */
+
+#ifndef RTPERFLOG_HPP
+#define RTPERFLOG_HPP
+
+#include "logger.h"
+
+namespace rtperflog {
+
+/**
+ * Defines a tag pair as a type with the names NAME_START and NAME_END and the fixed tags START and END. The tags are
+ * constant expressions, so a probe does not load them and they are valid before any initialization. Choose tags that
+ * do not collide with the tags of GENERATE_DEF, e.g. after TAG_COUNT. Example: RTPERFLOG_TAG(TAG_DEMO, 100, 101);
+ */
+#define RTPERFLOG_TAG(NAME, START, END)                                                                   \
+    struct NAME {                                                                                         \
+        enum : logger_logTag_t { start = (START), end = (END) };                                          \
+        static_assert((START) >= 0 && (START) <= LOGGER_TAG_MAX && (END) >= 0 && (END) <= LOGGER_TAG_MAX, \
+                      "The tags of " #NAME " are out of range");                                          \
+        static_assert((START) != (END), "The tags of " #NAME " are equal");                               \
+        static const char *startName() { return #NAME "_START"; }                                         \
+        static const char *endName() { return #NAME "_END"; }                                             \
+    }
+
+/**
+ * Returns the tag pair of Tag, e.g. for `logger_evaluate`.
+ */
+template <class Tag>
+inline logger_tagPair_t tagPair() {
+    logger_tagPair_t pair = {Tag::start, Tag::end};
+    return pair;
+}
+
+/**
+ * Registers the names of the tag pairs with their fixed tags in the tag registry of the logger, so the export and
+ * evaluate functions find them. Call it once at startup and again after `logger_freeTags`.
+ *
+ * @return 0=success;-1=a tag or name is already registered differently
+ */
+template <class... Tags>
+inline int registerTags() {
+    int ret = 0;
+    int expand[] = {0, (ret |= logger_registerTagWithId(Tags::start, Tags::startName()),
+                        ret |= logger_registerTagWithId(Tags::end, Tags::endName()), 0)...};
+    (void)expand;
+    return ret;
+}
+
+#ifndef RTPERFLOG_DISABLE
+
+/**
+ * Returns the list the probes of the current thread are written to. It is 0 until a `ListBinding` is created.
+ */
+inline int &threadList() {
+    static thread_local int list = 0;
+    return list;
+}
+
+/**
+ * Binds the probes of the current thread to a list for the lifetime of the object.
+ */
+class ListBinding {
+   public:
+    explicit ListBinding(int list) : previous_(threadList()) { threadList() = list; }
+    ~ListBinding() { threadList() = previous_; }
+    ListBinding(const ListBinding &) = delete;
+    ListBinding &operator=(const ListBinding &) = delete;
+
+   private:
+    int previous_;
+};
+
+/**
+ * Writes the START entry of Tag on construction and the END entry on destruction, so every return path ends the span.
+ * The list is taken from the thread binding when the span starts.
+ */
+template <class Tag>
+class ScopedSpan {
+   public:
+    explicit ScopedSpan(long id) : id_(id), list_(threadList()) {
+        logger_addLogEntry(Tag::start, id_, list_);
+    }
+    ScopedSpan(long id, int list) : id_(id), list_(list) { logger_addLogEntry(Tag::start, id_, list_); }
+    ~ScopedSpan() { logger_addLogEntry(Tag::end, id_, list_); }
+    ScopedSpan(const ScopedSpan &) = delete;
+    ScopedSpan &operator=(const ScopedSpan &) = delete;
+
+   private:
+    long id_;
+    int list_;
+};
+
+#define RTPERFLOG_CONCAT_(A, B) A##B
+#define RTPERFLOG_CONCAT(A, B) RTPERFLOG_CONCAT_(A, B)
+/**
+ * Starts a span of TAG with the given id, which ends with the enclosing scope.
+ */
+#define RTPERFLOG_SPAN(TAG, ID) ::rtperflog::ScopedSpan<TAG> RTPERFLOG_CONCAT(_rtperflog_span_, __LINE__)(ID)
+
+#else  // RTPERFLOG_DISABLE
+
+inline int &threadList() {
+    static int list = 0;
+    return list;
+}
+
+class ListBinding {
+   public:
+    explicit ListBinding(int) {}
+};
+
+template <class Tag>
+class ScopedSpan {
+   public:
+    explicit ScopedSpan(long) {}
+    ScopedSpan(long, int) {}
+};
+
+#define RTPERFLOG_SPAN(TAG, ID) ((void)0)
+
+#endif  // RTPERFLOG_DISABLE
+
+}  // namespace rtperflog
+
+#endif  // RTPERFLOG_HPP
@@ -18,13 +18,22 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <float.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "loggerFormat.h"
+#include "loggerHist.h"
 #include "loggerMem.h"
+#include "loggerUtil.h"
+
+// On LP64 targets the cpu of an entry fills the padding after the tag. Fails to compile when that does not hold.
+#if defined(__LP64__) || defined(_LP64)
+typedef char _logger_entrySizeCheck_t[sizeof(logger_logEntry_t) == 32 ? 1 : -1];
+#endif
 
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
 #include <windows.h>
@@ -38,14 +47,14 @@ static long ticks2nano;
 #ifdef __linux__
 
 #include <malloc.h>
+#include <sched.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 #include "limits.h"
 #include "time.h"
 #endif
 
-static __uint32_t u = 0;
-
 #ifdef __linux__
 #if defined(__amd64__)
 
@@ -53,12 +62,41 @@ static __uint32_t u = 0;
 //! Do NOT use this function for productiv systems!
 static inline __uint64_t _rdtscp(__uint32_t *aux) {
     __uint64_t rax, rdx;
-    asm volatile("rdtscp\n" : "=a"(rax), "=d"(rdx), "=c"(aux) : :);
+    asm volatile("rdtscp\n" : "=a"(rax), "=d"(rdx), "=c"(*aux) : :);
     return (rdx << 32) + rax;
 }
 #endif
 #endif
 
+// The outlier recorders read the lists of other threads while they are written. A writer stores an entry and then
+// publishes the new count with release semantics. A reader loads the count with acquire semantics before it reads the
+// entries. On x86 these are plain moves.
+#ifdef _MSC_VER
+static inline int64_t _logger_loadAcquire64(const int64_t *ptr) {
+    return InterlockedCompareExchange64((int64_t *)ptr, 0, 0);
+}
+static inline void _logger_storeRelease64(int64_t *ptr, int64_t value) { InterlockedExchange64(ptr, value); }
+static inline uint16_t _logger_loadAcquire16(const unsigned char *ptr) {
+    return (uint16_t)InterlockedCompareExchange16((SHORT *)ptr, 0, 0);
+}
+static inline void _logger_storeRelease16(unsigned char *ptr, uint16_t value) {
+    InterlockedExchange16((SHORT *)ptr, (SHORT)value);
+}
+static inline void _logger_fenceAcquire() { MemoryBarrier(); }
+#else
+static inline int64_t _logger_loadAcquire64(const int64_t *ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+static inline void _logger_storeRelease64(int64_t *ptr, int64_t value) {
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+static inline uint16_t _logger_loadAcquire16(const unsigned char *ptr) {
+    return __atomic_load_n((const uint16_t *)ptr, __ATOMIC_ACQUIRE);
+}
+static inline void _logger_storeRelease16(unsigned char *ptr, uint16_t value) {
+    __atomic_store_n((uint16_t *)ptr, value, __ATOMIC_RELEASE);
+}
+static inline void _logger_fenceAcquire() { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+#endif
+
 #ifdef WIN
 int clock_getAsFileTime(struct timespec *spec)  // C-file part
 {
@@ -126,36 +164,131 @@ void _getTime(struct timespec *time, logger_clockType_t type) {
     }
 #if defined(__amd64__)
     else if (type == LCLOCK_RDTSCP) {
-        time->tv_nsec = _rdtscp(&u);
+        __uint32_t aux;
+        time->tv_nsec = _rdtscp(&aux);
         time->tv_sec = 0;
     }
 #endif
 #endif
 }
 
+// Returns the CPU the calling thread runs on or -1, when it is not known.
+static inline int _logger_getCpu(void) {
+#ifdef WIN
+    return (int)GetCurrentProcessorNumber();
+#elif defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+// Reads the time and the CPU of a probe. With LCLOCK_RDTSCP both come from the same instruction. Linux stores the
+// CPU number in the lower 12 bits of IA32_TSC_AUX.
+static inline void _logger_getTimeCpu(struct timespec *time, int *cpu) {
+#if defined(__linux__) && defined(__amd64__)
+    if (_logger_config.clockType == LCLOCK_RDTSCP) {
+        __uint32_t aux;
+        time->tv_nsec = _rdtscp(&aux);
+        time->tv_sec = 0;
+        *cpu = (int)(aux & 0xfff);
+        return;
+    }
+#endif
+    _getTime(time, _logger_config.clockType);
+    *cpu = _logger_getCpu();
+}
+
 void logger_getTime(struct timespec *time) { _getTime(time, _logger_config.clockType); }
 
+// Frees the lists of logger_init after a failed allocation
+static void _logger_freeLists(void) {
+    free(_logger_nextEntry);
+    free(_logger_errorCount);
+    free(_logger_ringWrapped);
+    free(_logger_writeCount);
+    free(_logger_logEntryList);
+    free(_logger_blockList);
+    free(_logger_blockState);
+    _logger_nextEntry = NULL;
+    _logger_errorCount = NULL;
+    _logger_ringWrapped = NULL;
+    _logger_writeCount = NULL;
+    _logger_logEntryList = NULL;
+    _logger_blockList = NULL;
+    _logger_blockState = NULL;
+}
+
 int logger_init(logger_config_t conf) {
 #ifdef WIN
     QueryPerformanceFrequency((LARGE_INTEGER *)&qpcFreq);
     ticks2nano = exp9 / qpcFreq;
 #endif
+    // A config that is not zero-initialized has random values in the fields added after listSize
+    if (conf.listMode != LLIST_PLAIN && conf.listMode != LLIST_COMPRESSED && conf.listMode != LLIST_RING) {
+        printf("[Error] Unknown list mode %d, zero-initialize the config\n", conf.listMode);
+        return -1;
+    }
+    if (conf.recordCpu != 0 && conf.recordCpu != 1) {
+        printf("[Error] recordCpu must be 0 or 1, zero-initialize the config\n");
+        return -1;
+    }
+    if (conf.listCount <= 0 || conf.listSize <= 0) {
+        printf("[Error] listCount and listSize must be positive\n");
+        return -1;
+    }
     _logger_config = conf;
 
     _logger_nextEntry = (int *)calloc(conf.listCount, sizeof(int));
-    _logger_logEntryList = (logger_logEntry_t *)malloc(sizeof(logger_logEntry_t) * conf.listSize * conf.listCount);
     _logger_errorCount = (int *)calloc(conf.listCount, sizeof(int));
+    _logger_ringWrapped = (char *)calloc(conf.listCount, sizeof(char));
+    _logger_writeCount = (int64_t *)calloc(conf.listCount, sizeof(int64_t));
+    int allocated = _logger_nextEntry != NULL && _logger_errorCount != NULL && _logger_ringWrapped != NULL &&
+                    _logger_writeCount != NULL;
+    if (conf.listMode == LLIST_COMPRESSED) {
+        _logger_logEntryList = NULL;
+        _logger_blockList = (unsigned char *)calloc((size_t)conf.listSize * conf.listCount, LOGGER_BLOCK_SIZE);
+        _logger_blockState = (_logger_blockState_t *)calloc(conf.listCount, sizeof(_logger_blockState_t));
+        allocated = allocated && _logger_blockList != NULL && _logger_blockState != NULL;
+    } else {
+        _logger_logEntryList =
+            (logger_logEntry_t *)malloc(sizeof(logger_logEntry_t) * (size_t)conf.listSize * conf.listCount);
+        _logger_blockList = NULL;
+        _logger_blockState = NULL;
+        allocated = allocated && _logger_logEntryList != NULL;
+    }
+    if (!allocated) {
+        printf("[Error] Could not allocate the lists\n");
+        _logger_freeLists();
+        _logger_config.listCount = 0;
+        return -3;
+    }
+    int ret = 0;
 #ifndef WIN
-    int ret = mlock(_logger_nextEntry, sizeof(int) * conf.listCount);
-    ret += mlock(_logger_logEntryList, sizeof(logger_logEntry_t) * conf.listSize * conf.listCount);
+    ret = mlock(_logger_nextEntry, sizeof(int) * conf.listCount);
+    if (conf.listMode == LLIST_COMPRESSED) {
+        ret += mlock(_logger_blockList, (size_t)LOGGER_BLOCK_SIZE * conf.listSize * conf.listCount);
+        ret += mlock(_logger_blockState, sizeof(_logger_blockState_t) * conf.listCount);
+    } else {
+        ret += mlock(_logger_logEntryList, sizeof(logger_logEntry_t) * (size_t)conf.listSize * conf.listCount);
+    }
     ret += mlock(_logger_errorCount, sizeof(int) * conf.listCount);
+    ret += mlock(_logger_ringWrapped, sizeof(char) * conf.listCount);
+    ret += mlock(_logger_writeCount, sizeof(int64_t) * conf.listCount);
 #endif
 
     for (int i = 0; i < conf.listCount; i++) {
         _logger_nextEntry[i] = 0;
         _logger_errorCount[i] = 0;
+        if (conf.listMode == LLIST_COMPRESSED) {
+            _logger_blockState[i].offset = LOGGER_BLOCK_HEADER;
+        }
+    }
+    if (ret != 0) {
+        // The logger works, but page faults may hit the probes
+        printf("[Warning] Could not pin the memory of the lists: %s\n", strerror(errno));
+        return 1;
     }
-    // TODO error
     return 0;
 }
 
@@ -163,7 +296,714 @@ void logger_reset() {
     for (int i = 0; i < _logger_config.listCount; i++) {
         _logger_nextEntry[i] = 0;
         _logger_errorCount[i] = 0;
+        _logger_ringWrapped[i] = 0;
+        _logger_writeCount[i] = 0;
+        if (_logger_config.listMode == LLIST_COMPRESSED) {
+            memset(&_logger_blockList[(size_t)i * _logger_config.listSize * LOGGER_BLOCK_SIZE], 0,
+                   (size_t)(_logger_blockState[i].block + 1) * LOGGER_BLOCK_SIZE);
+            memset(&_logger_blockState[i], 0, sizeof(_logger_blockState_t));
+            _logger_blockState[i].offset = LOGGER_BLOCK_HEADER;
+        }
+    }
+    if (_logger_sampleList != NULL) {
+        memset(_logger_sampleList, 0,
+               sizeof(_logger_sampleList_t) * _logger_sampleStateCount * _logger_config.listCount);
+    }
+    for (int i = 0; i < _logger_outlierStateCount; i++) {
+        _logger_outlierState[i].count = 0;
+        _logger_outlierState[i].seen = 0;
+        _logger_outlierState[i].dropped = 0;
+        _logger_outlierState[i].pendingHead = 0;
+        _logger_outlierState[i].pendingCount = 0;
+        memset(_logger_outlierState[i].open, 0, sizeof(_logger_outlierState[i].open));
+    }
+}
+
+// Appends an entry to a compressed list. The cost is bounded by LOGGER_ENTRY_MAXENC byte writes.
+static inline int _logger_addCompressed(logger_logTag_t tag, long id, int listNumber, struct timespec time, int cpu) {
+    _logger_blockState_t *state = &_logger_blockState[listNumber];
+    if (state->offset > LOGGER_BLOCK_SIZE - LOGGER_ENTRY_MAXENC - (_logger_config.recordCpu ? LOGGER_CPU_MAXENC : 0)) {
+        if (state->block + 1 >= _logger_config.listSize) {
+            _logger_errorCount[listNumber]++;
+            return -2;
+        }
+        state->block++;
+        state->offset = LOGGER_BLOCK_HEADER;
+        state->lastTag = 0;
+        state->lastId = 0;
+        state->lastTime = 0;
+        state->lastCpu = 0;
+    }
+    unsigned char *block =
+        &_logger_blockList[((size_t)listNumber * _logger_config.listSize + state->block) * LOGGER_BLOCK_SIZE];
+    int64_t ns = _logger_timespecToNs(time);
+    int offset = state->offset;
+    offset += _logger_putVarint(&block[offset], _logger_zigzag((int64_t)tag - state->lastTag));
+    offset += _logger_putVarint(&block[offset], _logger_zigzag((int64_t)((uint64_t)id - state->lastId)));
+    offset += _logger_putVarint(&block[offset], _logger_zigzag(ns - state->lastTime));
+    if (_logger_config.recordCpu) {
+        offset += _logger_putVarint(&block[offset], _logger_zigzag((int64_t)cpu - state->lastCpu));
+        state->lastCpu = cpu;
+    }
+    _logger_storeRelease16(block, _logger_blockCount(block) + 1);
+    state->offset = offset;
+    state->lastTag = tag;
+    state->lastId = (uint64_t)id;
+    state->lastTime = ns;
+    _logger_nextEntry[listNumber]++;
+    return 0;
+}
+
+// Makes sure that the tag lookup table covers maxTag.
+static void _logger_growTagState(int maxTag) {
+    if (maxTag < _logger_tagStateCount) {
+        return;
+    }
+    _logger_tagState = (_logger_tagState_t *)realloc(_logger_tagState, sizeof(_logger_tagState_t) * (maxTag + 1));
+    for (int i = _logger_tagStateCount; i <= maxTag; i++) {
+        _logger_tagState[i].sample = -1;
+        _logger_tagState[i].outlier = -1;
+        _logger_tagState[i].isStart = 0;
+    }
+    _logger_tagStateCount = maxTag + 1;
+}
+
+int logger_setSampling(logger_tagPair_t pair, logger_sampleMode_t mode, unsigned long param) {
+    if (pair.tag_start < 0 || pair.tag_end < 0 || _logger_config.listCount <= 0) {
+        return -1;
+    }
+    _logger_growTagState(pair.tag_start > pair.tag_end ? pair.tag_start : pair.tag_end);
+    int idx = -1;
+    for (int i = 0; i < _logger_sampleStateCount; i++) {
+        if (_logger_sampleState[i].pair.tag_start == pair.tag_start &&
+            _logger_sampleState[i].pair.tag_end == pair.tag_end) {
+            idx = i;
+        }
+    }
+    int count = _logger_sampleStateCount;
+    if (idx < 0) {
+        _logger_sampleState =
+            (_logger_sampleState_t *)realloc(_logger_sampleState, sizeof(_logger_sampleState_t) * (count + 1));
+        idx = count++;
+    }
+    // The per list state is laid out again for the new count of tag pairs. The state of the other pairs is kept.
+    _logger_sampleList_t *lists =
+        (_logger_sampleList_t *)calloc((size_t)count * _logger_config.listCount, sizeof(_logger_sampleList_t));
+    for (int l = 0; l < _logger_config.listCount; l++) {
+        for (int i = 0; i < _logger_sampleStateCount; i++) {
+            if (i != idx) {
+                lists[l * count + i] = _logger_sampleList[l * _logger_sampleStateCount + i];
+            }
+        }
+    }
+#ifndef WIN
+    if (_logger_sampleList != NULL) {
+        munlock(_logger_sampleList,
+                sizeof(_logger_sampleList_t) * _logger_sampleStateCount * _logger_config.listCount);
+    }
+    mlock(lists, sizeof(_logger_sampleList_t) * count * _logger_config.listCount);
+#endif
+    free(_logger_sampleList);
+    _logger_sampleList = lists;
+    _logger_sampleStateCount = count;
+    _logger_sampleState_t *state = &_logger_sampleState[idx];
+    memset(state, 0, sizeof(_logger_sampleState_t));
+    state->pair = pair;
+    state->mode = mode;
+    if (mode == LSAMPLE_ONE_IN_N) {
+        if (param <= 1) {
+            state->mode = LSAMPLE_ALL;
+        } else {
+            // Probes are kept when the hashed id is below this threshold
+            state->param = UINT64_MAX / param;
+        }
+    } else {
+        state->param = param;
+    }
+    _logger_tagState[pair.tag_start].sample = state->mode == LSAMPLE_ALL ? -1 : idx;
+    _logger_tagState[pair.tag_start].isStart = 1;
+    _logger_tagState[pair.tag_end].sample = state->mode == LSAMPLE_ALL ? -1 : idx;
+    _logger_tagState[pair.tag_end].isStart = 0;
+    return 0;
+}
+
+// Decides whether a probe of a sampled tag is recorded. time is only used in LSAMPLE_PERIOD mode. In this mode a list
+// keeps no new START while the span it kept last is still open, so every kept START gets its END.
+static inline int _logger_sampleProbe(const _logger_sampleState_t *state, _logger_sampleList_t *list, int isStart,
+                                      long id, struct timespec time) {
+    if (isStart) {
+        list->seen++;
+    }
+    if (state->mode == LSAMPLE_ONE_IN_N) {
+        // Fibonacci hashing spreads consecutive ids evenly
+        if ((uint64_t)id * 0x9E3779B97F4A7C15ull >= state->param) {
+            return 0;
+        }
+    } else if (isStart) {
+        int64_t ns = _logger_timespecToNs(time);
+        if (list->open || ns < list->nextTime) {
+            return 0;
+        }
+        list->nextTime = ns + (int64_t)state->param;
+        list->openId = (unsigned long)id;
+        list->open = 1;
+    } else {
+        if (!list->open || list->openId != (unsigned long)id) {
+            return 0;
+        }
+        list->open = 0;
+    }
+    if (isStart) {
+        list->kept++;
+    }
+    return 1;
+}
+
+// Returns the entry to write next or NULL when the list is full. In LLIST_RING mode the oldest entry is overwritten.
+static inline logger_logEntry_t *_logger_nextSlot(int listNumber) {
+    if (_logger_nextEntry[listNumber] >= _logger_config.listSize) {
+        if (_logger_config.listMode != LLIST_RING) {
+            _logger_errorCount[listNumber]++;
+            return NULL;
+        }
+        _logger_nextEntry[listNumber] = 0;
+        _logger_ringWrapped[listNumber] = 1;
+    }
+    return &_logger_logEntryList[listNumber * _logger_config.listSize + _logger_nextEntry[listNumber]++];
+}
+
+static inline int _logger_storeEntry(logger_logTag_t tag, long id, int listNumber, struct timespec time, int cpu) {
+    if (_logger_config.listMode == LLIST_COMPRESSED) {
+        return _logger_addCompressed(tag, id, listNumber, time, cpu);
+    }
+    logger_logEntry_t *entr = _logger_nextSlot(listNumber);
+    if (entr == NULL) {
+        return -2;
+    }
+    entr->time_stamp = time;
+    entr->id = id;
+    entr->tag = tag;
+    entr->cpu = cpu;
+    _logger_storeRelease64(&_logger_writeCount[listNumber], _logger_writeCount[listNumber] + 1);
+    return 0;
+}
+
+// Streaming reader for the entries of one list. It hides the storage mode of the list from the export and evaluate
+// functions.
+typedef struct {
+    int list;
+    int pos;
+    int start;
+    int count;
+    // Only used in LLIST_COMPRESSED mode
+    const unsigned char *block;
+    int blockIdx;
+    int offset;
+    int blockLeft;
+    int64_t tag;
+    uint64_t id;
+    int64_t time;
+    int64_t cpu;
+} _logger_listIter_t;
+
+static void _logger_iterInit(_logger_listIter_t *it, int listNumber) {
+    memset(it, 0, sizeof(_logger_listIter_t));
+    it->list = listNumber;
+    it->blockIdx = -1;
+    it->count = _logger_nextEntry[listNumber];
+    if (_logger_config.listMode == LLIST_RING && _logger_ringWrapped[listNumber]) {
+        // The oldest entry is the one that is overwritten next
+        it->start = _logger_nextEntry[listNumber];
+        it->count = _logger_config.listSize;
+    }
+}
+
+// Starts a reader at a block of a compressed list that may still be written. It stops at the first empty block.
+static void _logger_iterInitBlock(_logger_listIter_t *it, int listNumber, int block) {
+    memset(it, 0, sizeof(_logger_listIter_t));
+    it->list = listNumber;
+    it->blockIdx = block - 1;
+    it->count = INT_MAX;
+}
+
+static int _logger_iterNext(_logger_listIter_t *it, logger_logEntry_t *entry) {
+    if (it->pos >= it->count) {
+        return 0;
+    }
+    if (_logger_config.listMode != LLIST_COMPRESSED) {
+        int idx = (it->start + it->pos) % _logger_config.listSize;
+        *entry = _logger_logEntryList[it->list * _logger_config.listSize + idx];
+        it->pos++;
+        return 1;
+    }
+    while (it->blockLeft == 0) {
+        // Only the last used block is not full, so the first empty block ends the list
+        if (it->blockIdx + 1 >= _logger_config.listSize) {
+            return 0;
+        }
+        it->blockIdx++;
+        it->block = &_logger_blockList[((size_t)it->list * _logger_config.listSize + it->blockIdx) * LOGGER_BLOCK_SIZE];
+        it->blockLeft = _logger_loadAcquire16(it->block);
+        if (it->blockLeft == 0) {
+            return 0;
+        }
+        it->offset = LOGGER_BLOCK_HEADER;
+        it->tag = 0;
+        it->id = 0;
+        it->time = 0;
+        it->cpu = 0;
+    }
+    uint64_t v;
+    it->offset += _logger_getVarint(&it->block[it->offset], &v);
+    it->tag += _logger_unzigzag(v);
+    it->offset += _logger_getVarint(&it->block[it->offset], &v);
+    it->id += (uint64_t)_logger_unzigzag(v);
+    it->offset += _logger_getVarint(&it->block[it->offset], &v);
+    it->time += _logger_unzigzag(v);
+    if (_logger_config.recordCpu) {
+        it->offset += _logger_getVarint(&it->block[it->offset], &v);
+        it->cpu += _logger_unzigzag(v);
+    }
+    it->blockLeft--;
+    it->pos++;
+
+    entry->tag = (logger_logTag_t)it->tag;
+    entry->cpu = _logger_config.recordCpu ? (int)it->cpu : -1;
+    entry->id = (unsigned long)it->id;
+    entry->time_stamp = _logger_nsToTimespec(it->time);
+    return 1;
+}
+
+// Timestamp of the entry with the sequence number seq of a plain or ring list
+static inline int64_t _logger_seqTime(int listNumber, int64_t seq) {
+    return _logger_timespecToNs(
+        _logger_logEntryList[(size_t)listNumber * _logger_config.listSize + seq % _logger_config.listSize].time_stamp);
+}
+
+// Returns the first sequence number in [lo, hi) of a plain or ring list whose entry is newer than ns, or hi. The
+// entries of a list are expected in time order.
+static int64_t _logger_seqSearch(int listNumber, int64_t lo, int64_t hi, int64_t ns) {
+    while (lo < hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (_logger_seqTime(listNumber, mid) > ns) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+// Oldest sequence number of a plain or ring list that is not overwritten by a write in progress
+static inline int64_t _logger_seqOldest(int64_t written) {
+    if (_logger_config.listMode != LLIST_RING || written < _logger_config.listSize) {
+        return 0;
     }
+    return written - _logger_config.listSize + 1;
+}
+
+// Timestamp of the first entry of a compressed block. It is stored relative to zero.
+static inline int64_t _logger_blockFirstTime(const unsigned char *block) {
+    uint64_t v;
+    int offset = LOGGER_BLOCK_HEADER;
+    offset += _logger_getVarint(&block[offset], &v);
+    offset += _logger_getVarint(&block[offset], &v);
+    _logger_getVarint(&block[offset], &v);
+    return _logger_unzigzag(v);
+}
+
+// Entry count of a block of a compressed list
+static inline int _logger_blockEntries(int listNumber, int64_t block) {
+    return _logger_loadAcquire16(
+        &_logger_blockList[((size_t)listNumber * _logger_config.listSize + block) * LOGGER_BLOCK_SIZE]);
+}
+
+// Returns the first block of a compressed list that is empty or whose first entry is newer than ns
+static int64_t _logger_blockSearch(int listNumber, int64_t ns) {
+    int64_t lo = 0;
+    int64_t hi = _logger_config.listSize;
+    while (lo < hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        const unsigned char *block =
+            &_logger_blockList[((size_t)listNumber * _logger_config.listSize + mid) * LOGGER_BLOCK_SIZE];
+        if (_logger_loadAcquire16(block) == 0 || _logger_blockFirstTime(block) > ns) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+// Initializes an iterator that decodes the blocks [first, last] of a compressed list
+static void _logger_iterInitBlocks(_logger_listIter_t *it, int listNumber, int64_t first, int64_t last) {
+    int count = 0;
+    for (int64_t b = first; b <= last; b++) {
+        count += _logger_blockEntries(listNumber, b);
+    }
+    _logger_iterInitBlock(it, listNumber, (int)first);
+    it->count = count;
+}
+
+// Counts the entries of one block of a compressed list in [from, to]
+static int64_t _logger_blockCountWindow(int listNumber, int64_t block, int64_t from, int64_t to) {
+    _logger_listIter_t it;
+    logger_logEntry_t entry;
+    int64_t count = 0;
+    _logger_iterInitBlocks(&it, listNumber, block, block);
+    while (_logger_iterNext(&it, &entry)) {
+        count += it.time >= from && it.time <= to;
+    }
+    return count;
+}
+
+// Finds the part of a list in [from, to]. Plain and ring lists are searched by sequence number. Compressed lists are
+// searched by the first entry of each block. Their count stops at limit, so that the cost does not grow with the
+// entries in the window: only the first and the last block are decoded, the blocks between are counted by their
+// header.
+static void _logger_findWindow(int listNumber, int64_t from, int64_t to, int64_t limit, _logger_ctxList_t *window) {
+    if (_logger_config.listMode != LLIST_COMPRESSED) {
+        int64_t written = _logger_loadAcquire64(&_logger_writeCount[listNumber]);
+        window->first = _logger_seqSearch(listNumber, _logger_seqOldest(written), written, from - 1);
+        window->count = _logger_seqSearch(listNumber, window->first, written, to) - window->first;
+        return;
+    }
+    int64_t first = _logger_blockSearch(listNumber, from - 1) - 1;
+    window->first = first > 0 ? first : 0;
+    window->last = _logger_blockSearch(listNumber, to) - 1;
+    window->count = 0;
+    if (window->last < 0) {
+        return;
+    }
+    window->count = _logger_blockCountWindow(listNumber, window->first, from, to);
+    if (window->last > window->first) {
+        for (int64_t b = window->first + 1; b < window->last && window->count < limit; b++) {
+            window->count += _logger_blockEntries(listNumber, b);
+        }
+        if (window->count < limit) {
+            window->count += _logger_blockCountWindow(listNumber, window->last, from, to);
+        }
+    }
+    if (window->count > limit) {
+        window->count = limit;
+    }
+}
+
+// Splits the context entries of a span over the lists. A list that needs less than an even share leaves the rest to
+// the others.
+static void _logger_splitBudget(_logger_ctxList_t *lists, int listCount, int budget) {
+    int left = listCount;
+    for (int j = 0; j < listCount; j++) {
+        lists[j].budget = -1;
+    }
+    for (int changed = 1; changed && left > 0;) {
+        changed = 0;
+        int share = budget / left;
+        for (int j = 0; j < listCount; j++) {
+            if (lists[j].budget < 0 && lists[j].count <= share) {
+                lists[j].budget = (int)lists[j].count;
+                budget -= lists[j].budget;
+                left--;
+                changed = 1;
+            }
+        }
+    }
+    for (int j = 0, n = 0; j < listCount; j++) {
+        if (lists[j].budget < 0) {
+            lists[j].budget = budget / left + (n++ < budget % left ? 1 : 0);
+        }
+    }
+}
+
+static void _logger_ctxReverse(_logger_ctxEntry_t *ctx, int lo, int hi) {
+    for (hi--; lo < hi; lo++, hi--) {
+        _logger_ctxEntry_t tmp = ctx[lo];
+        ctx[lo] = ctx[hi];
+        ctx[hi] = tmp;
+    }
+}
+
+// Rotates count entries left by shift in place, so the oldest entry of a full ring comes first
+static void _logger_ctxRotate(_logger_ctxEntry_t *ctx, int count, int shift) {
+    _logger_ctxReverse(ctx, 0, shift);
+    _logger_ctxReverse(ctx, shift, count);
+    _logger_ctxReverse(ctx, 0, count);
+}
+
+// Copies the part of a list in the window to ctx. When it holds more than window->budget entries, the first and the
+// last ones are copied, so the context before and after the span is kept. Returns the count of copied entries.
+static int _logger_copyWindow(int listNumber, const _logger_ctxList_t *window, int64_t from, int64_t to,
+                              _logger_ctxEntry_t *ctx) {
+    int64_t lead = window->count <= window->budget ? window->count : (window->budget + 1) / 2;
+    int64_t trail = window->count <= window->budget ? 0 : window->budget - lead;
+    int copied = 0;
+    if (_logger_config.listMode == LLIST_COMPRESSED) {
+        if (window->count == 0) {
+            return 0;
+        }
+        _logger_listIter_t it;
+        logger_logEntry_t entry;
+        _logger_iterInitBlock(&it, listNumber, (int)window->first);
+        while (copied < lead && _logger_iterNext(&it, &entry) && it.time <= to) {
+            if (it.time >= from) {
+                ctx[copied].entry = entry;
+                ctx[copied].list = listNumber;
+                copied++;
+            }
+        }
+        if (trail == 0) {
+            return copied;
+        }
+        // The last trail entries are kept in a ring. Its blocks are found backwards by their entry count, so only
+        // about trail entries and two blocks are decoded.
+        int64_t block = window->last;
+        int64_t entries = _logger_blockCountWindow(listNumber, block, from, to);
+        while (entries < trail && block > window->first) {
+            block--;
+            entries += _logger_blockEntries(listNumber, block);
+        }
+        _logger_ctxEntry_t *ring = &ctx[copied];
+        int64_t n = 0;
+        _logger_iterInitBlocks(&it, listNumber, block, window->last);
+        while (_logger_iterNext(&it, &entry) && it.time <= to) {
+            if (it.time >= from) {
+                ring[n % trail].entry = entry;
+                ring[n % trail].list = listNumber;
+                n++;
+            }
+        }
+        if (n > trail) {
+            _logger_ctxRotate(ring, (int)trail, (int)(n % trail));
+        }
+        return copied + (int)(n < trail ? n : trail);
+    }
+    int64_t ranges[2][2] = {{window->first, window->first + lead},
+                            {window->first + window->count - trail, window->first + window->count}};
+    for (int r = 0; r < 2; r++) {
+        for (int64_t seq = ranges[r][0]; seq < ranges[r][1]; seq++) {
+            ctx[copied].entry =
+                _logger_logEntryList[(size_t)listNumber * _logger_config.listSize + seq % _logger_config.listSize];
+            ctx[copied].list = listNumber;
+            copied++;
+        }
+    }
+    // A ring list may have been overwritten during the copy. The overwritten entries are the oldest ones. The time
+    // check drops entries that were found by a search over overwritten entries.
+    _logger_fenceAcquire();
+    int64_t oldest = _logger_seqOldest(_logger_loadAcquire64(&_logger_writeCount[listNumber]));
+    int stale = 0;
+    for (int r = 0; r < 2; r++) {
+        int64_t n = oldest - ranges[r][0];
+        stale += (int)(n < 0 ? 0 : n > ranges[r][1] - ranges[r][0] ? ranges[r][1] - ranges[r][0] : n);
+    }
+    int kept = 0;
+    for (int c = stale; c < copied; c++) {
+        int64_t ns = _logger_timespecToNs(ctx[c].entry.time_stamp);
+        if (ns >= from && ns <= to) {
+            ctx[kept++] = ctx[c];
+        }
+    }
+    return kept;
+}
+
+// Copies the entries of all lists in [start - window, end + window] into the context region of a span. The region of
+// contextSize entries is split over the lists.
+static void _logger_copyContext(_logger_outlierState_t *state, const _logger_outlierSpan_t *span) {
+    _logger_ctxEntry_t *ctx = &state->context[(size_t)span->ctx * state->contextSize];
+    int64_t from = span->start - state->window;
+    int64_t to = span->end + state->window;
+    for (int j = 0; j < _logger_config.listCount; j++) {
+        _logger_findWindow(j, from, to, state->contextSize + 1, &state->lists[j]);
+    }
+    _logger_splitBudget(state->lists, _logger_config.listCount, state->contextSize);
+    int copied = 0;
+    for (int j = 0; j < _logger_config.listCount; j++) {
+        copied += _logger_copyWindow(j, &state->lists[j], from, to, &ctx[copied]);
+    }
+    state->contextCount[span->ctx] = copied;
+}
+
+static inline void _logger_outlierSwap(_logger_outlierSpan_t *a, _logger_outlierSpan_t *b) {
+    _logger_outlierSpan_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// The upper 6 bits of the hashed id select the home slot of an open span
+static inline int _logger_openSlot(unsigned long id) { return (int)(((uint64_t)id * 0x9E3779B97F4A7C15ull) >> 58); }
+
+// Adds a started span. When LOGGER_OUTLIER_OPEN spans are open, the START is dropped and counted.
+static void _logger_openPut(_logger_outlierState_t *state, unsigned long id, int64_t start, int cpu) {
+    int slot = _logger_openSlot(id);
+    for (int n = 0; n < LOGGER_OUTLIER_OPEN; n++) {
+        _logger_openSpan_t *open = &state->open[(slot + n) & (LOGGER_OUTLIER_OPEN - 1)];
+        if (!open->used || open->id == id) {
+            open->id = id;
+            open->start = start;
+            open->cpu = cpu;
+            open->used = 1;
+            return;
+        }
+    }
+    state->dropped++;
+}
+
+// Removes the open span of an id. Returns 0 if the id is not open.
+static int _logger_openTake(_logger_outlierState_t *state, unsigned long id, _logger_openSpan_t *span) {
+    const int mask = LOGGER_OUTLIER_OPEN - 1;
+    int hole = _logger_openSlot(id);
+    int n = 0;
+    while (!state->open[hole].used || state->open[hole].id != id) {
+        if (!state->open[hole].used || ++n == LOGGER_OUTLIER_OPEN) {
+            return 0;
+        }
+        hole = (hole + 1) & mask;
+    }
+    *span = state->open[hole];
+    // Backward shift deletion moves the later spans of the probe sequence into the hole, so no tombstones are needed
+    for (int next = (hole + 1) & mask; next != hole && state->open[next].used; next = (next + 1) & mask) {
+        int home = _logger_openSlot(state->open[next].id);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            state->open[hole] = state->open[next];
+            hole = next;
+        }
+    }
+    state->open[hole].used = 0;
+    return 1;
+}
+
+static inline void _logger_popPending(_logger_outlierState_t *state) {
+    state->pendingHead = (state->pendingHead + 1) % (2 * state->k);
+    state->pendingCount--;
+}
+
+// Queues a span whose context is copied once its window has passed
+static void _logger_pushPending(_logger_outlierState_t *state, const _logger_outlierSpan_t *span) {
+    int capacity = 2 * state->k;
+    if (state->pendingCount == capacity) {
+        // At most k spans are not stale, so dropping the stale ones makes room
+        int count = 0;
+        for (int i = 0; i < state->pendingCount; i++) {
+            _logger_pendingSpan_t pending = state->pending[(state->pendingHead + i) % capacity];
+            if (pending.gen == state->contextGen[pending.span.ctx]) {
+                state->pending[(state->pendingHead + count++) % capacity] = pending;
+            }
+        }
+        state->pendingCount = count;
+    }
+    _logger_pendingSpan_t *pending = &state->pending[(state->pendingHead + state->pendingCount) % capacity];
+    pending->span = *span;
+    pending->gen = state->contextGen[span->ctx];
+    state->pendingCount++;
+}
+
+static void _logger_outlierProbe(_logger_outlierState_t *state, int isStart, long id, struct timespec time, int cpu) {
+    int64_t ns = _logger_timespecToNs(time);
+    // Copy the context of the oldest pending span once its window has passed. A probe makes at most one copy.
+    while (state->pendingCount > 0) {
+        _logger_pendingSpan_t *pending = &state->pending[state->pendingHead];
+        if (pending->gen == state->contextGen[pending->span.ctx]) {
+            if (ns <= pending->span.end + state->window) {
+                break;
+            }
+            _logger_copyContext(state, &pending->span);
+            _logger_popPending(state);
+            break;
+        }
+        _logger_popPending(state);
+    }
+    if (isStart) {
+        _logger_openPut(state, (unsigned long)id, ns, cpu);
+        return;
+    }
+    _logger_openSpan_t open;
+    if (!_logger_openTake(state, (unsigned long)id, &open)) {
+        return;
+    }
+    state->seen++;
+    _logger_outlierSpan_t span;
+    span.id = (unsigned long)id;
+    span.start = open.start;
+    span.end = ns;
+    span.startCpu = open.cpu;
+    span.endCpu = cpu;
+    _logger_outlierSpan_t *heap = state->heap;
+    int pos;
+    if (state->count < state->k) {
+        span.ctx = state->count;
+        pos = state->count++;
+        heap[pos] = span;
+        // sift up
+        while (pos > 0 && heap[(pos - 1) / 2].end - heap[(pos - 1) / 2].start > span.end - span.start) {
+            _logger_outlierSwap(&heap[pos], &heap[(pos - 1) / 2]);
+            pos = (pos - 1) / 2;
+        }
+    } else if (span.end - span.start > heap[0].end - heap[0].start) {
+        span.ctx = heap[0].ctx;
+        heap[0] = span;
+        // sift down
+        pos = 0;
+        for (;;) {
+            int smallest = pos;
+            int l = 2 * pos + 1;
+            int r = 2 * pos + 2;
+            if (l < state->count && heap[l].end - heap[l].start < heap[smallest].end - heap[smallest].start) {
+                smallest = l;
+            }
+            if (r < state->count && heap[r].end - heap[r].start < heap[smallest].end - heap[smallest].start) {
+                smallest = r;
+            }
+            if (smallest == pos) {
+                break;
+            }
+            _logger_outlierSwap(&heap[pos], &heap[smallest]);
+            pos = smallest;
+        }
+    } else {
+        return;
+    }
+    // The context region now belongs to this span. A pending copy for the span it replaced becomes stale.
+    state->contextGen[span.ctx]++;
+    state->contextCount[span.ctx] = 0;
+    _logger_pushPending(state, &span);
+}
+
+// Slow path of the probes for tags with sampling or outlier recording.
+static int _logger_addHooked(logger_logTag_t tag, long id, int listNumber, const struct timespec *custTime) {
+    _logger_tagState_t *tagState = &_logger_tagState[tag];
+    struct timespec time = {0, 0};
+    int hasTime = 0;
+    int cpu = -1;
+    if (custTime != NULL) {
+        time = *custTime;
+        hasTime = 1;
+        cpu = _logger_config.recordCpu ? _logger_getCpu() : -1;
+    }
+    if (tagState->sample >= 0) {
+        _logger_sampleState_t *sampling = &_logger_sampleState[tagState->sample];
+        if (!hasTime && sampling->mode == LSAMPLE_PERIOD && tagState->isStart) {
+            if (_logger_config.recordCpu) {
+                _logger_getTimeCpu(&time, &cpu);
+            } else {
+                _getTime(&time, _logger_config.clockType);
+            }
+            hasTime = 1;
+        }
+        _logger_sampleList_t *list = &_logger_sampleList[listNumber * _logger_sampleStateCount + tagState->sample];
+        if (!_logger_sampleProbe(sampling, list, tagState->isStart, id, time)) {
+            return 1;
+        }
+    }
+    if (!hasTime && _logger_config.recordCpu) {
+        _logger_getTimeCpu(&time, &cpu);
+    } else if (!hasTime) {
+        _getTime(&time, _logger_config.clockType);
+    }
+    int ret = _logger_storeEntry(tag, id, listNumber, time, cpu);
+    if (tagState->outlier >= 0) {
+        _logger_outlierProbe(&_logger_outlierState[tagState->outlier], tagState->isStart, id, time, cpu);
+    }
+    return ret;
 }
 
 int logger_addLogEntry(logger_logTag_t tag, long id, int listNumber) {
@@ -171,16 +1011,33 @@ int logger_addLogEntry(logger_logTag_t tag, long id, int listNumber) {
         _logger_errorCount[listNumber]++;
         return -1;
     }
-    if (_logger_nextEntry[listNumber] >= _logger_config.listSize) {
-        _logger_errorCount[listNumber]++;
+    if (tag >= 0 && tag < _logger_tagStateCount &&
+        (_logger_tagState[tag].sample >= 0 || _logger_tagState[tag].outlier >= 0)) {
+        return _logger_addHooked(tag, id, listNumber, NULL);
+    }
+    if (_logger_config.listMode == LLIST_COMPRESSED) {
+        struct timespec time;
+        int cpu = -1;
+        if (_logger_config.recordCpu) {
+            _logger_getTimeCpu(&time, &cpu);
+        } else {
+            _getTime(&time, _logger_config.clockType);
+        }
+        return _logger_addCompressed(tag, id, listNumber, time, cpu);
+    }
+    logger_logEntry_t *entr = _logger_nextSlot(listNumber);
+    if (entr == NULL) {
         return -2;
     }
-    logger_logEntry_t *entr =
-        &_logger_logEntryList[listNumber * _logger_config.listSize + _logger_nextEntry[listNumber]];
-    _getTime(&(entr->time_stamp), _logger_config.clockType);
+    if (_logger_config.recordCpu) {
+        _logger_getTimeCpu(&(entr->time_stamp), &(entr->cpu));
+    } else {
+        _getTime(&(entr->time_stamp), _logger_config.clockType);
+        entr->cpu = -1;
+    }
     entr->id = id;
     entr->tag = tag;
-    _logger_nextEntry[listNumber]++;
+    _logger_storeRelease64(&_logger_writeCount[listNumber], _logger_writeCount[listNumber] + 1);
 
     return 0;
 }
@@ -190,20 +1047,152 @@ int logger_addLogEntryCustTime(logger_logTag_t tag, long id, int listNumber, str
         _logger_errorCount[listNumber]++;
         return -1;
     }
-    if (_logger_nextEntry[listNumber] >= _logger_config.listSize) {
-        _logger_errorCount[listNumber]++;
-        return -2;
-    } else {
-        logger_logEntry_t *entr =
-            &_logger_logEntryList[listNumber * _logger_config.listSize + _logger_nextEntry[listNumber]];
-        entr->time_stamp = time;
-        entr->id = id;
-        entr->tag = tag;
-        _logger_nextEntry[listNumber]++;
+    if (tag >= 0 && tag < _logger_tagStateCount &&
+        (_logger_tagState[tag].sample >= 0 || _logger_tagState[tag].outlier >= 0)) {
+        return _logger_addHooked(tag, id, listNumber, &time);
+    }
+    return _logger_storeEntry(tag, id, listNumber, time, _logger_config.recordCpu ? _logger_getCpu() : -1);
+}
+
+// Returns the slot of a name in the hash table of the registry. The slot is free, when the name is not registered.
+static int _logger_tagSlot(const char *name) {
+    int mask = _logger_tagHashSize - 1;
+    int slot = (int)(_logger_hashName(name) & (uint64_t)mask);
+    while (_logger_tagHash[slot] >= 0 && strcmp(_logger_tagNames[_logger_tagHash[slot]], name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void _logger_tagRehash(int size) {
+    free(_logger_tagHash);
+    _logger_tagHash = (int *)malloc(sizeof(int) * size);
+    _logger_tagHashSize = size;
+    for (int i = 0; i < size; i++) {
+        _logger_tagHash[i] = -1;
+    }
+    for (int tag = 0; tag < _logger_tagNameCount; tag++) {
+        if (_logger_tagNames[tag] != NULL) {
+            _logger_tagHash[_logger_tagSlot(_logger_tagNames[tag])] = tag;
+        }
+    }
+}
+
+int logger_registerTagWithId(logger_logTag_t tag, const char *name) {
+    if (name == NULL) {
+        return -1;
+    }
+    if (tag < 0 || tag > LOGGER_TAG_MAX) {
+        printf("[Error] Tag %d of %s is out of range\n", tag, name);
+        return -1;
+    }
+    if (_logger_tagHashSize == 0) {
+        _logger_tagRehash(64);
+    }
+    int slot = _logger_tagSlot(name);
+    if (_logger_tagHash[slot] >= 0) {
+        if (_logger_tagHash[slot] == tag) {
+            return 0;
+        }
+        printf("[Error] Tag %s is already registered as %d\n", name, _logger_tagHash[slot]);
+        return -1;
+    }
+    if (tag < _logger_tagNameCount && _logger_tagNames[tag] != NULL) {
+        printf("[Error] Tag %d is already registered as %s\n", tag, _logger_tagNames[tag]);
+        return -1;
+    }
+    if (tag >= _logger_tagNameCount) {
+        _logger_tagNames = (char **)realloc(_logger_tagNames, sizeof(char *) * (tag + 1));
+        for (int i = _logger_tagNameCount; i <= tag; i++) {
+            _logger_tagNames[i] = NULL;
+        }
+        _logger_tagNameCount = tag + 1;
+    }
+    _logger_tagNames[tag] = (char *)malloc(strlen(name) + 1);
+    strcpy(_logger_tagNames[tag], name);
+    _logger_tagHash[slot] = tag;
+    _logger_tagNameUsed++;
+    if (_logger_tagNameUsed * 2 > _logger_tagHashSize) {
+        _logger_tagRehash(_logger_tagHashSize * 2);
     }
     return 0;
 }
 
+logger_logTag_t logger_registerTag(const char *name) {
+    logger_logTag_t tag = logger_findTag(name);
+    if (tag >= 0) {
+        return tag;
+    }
+    tag = _logger_tagNameCount;
+    if (logger_registerTagWithId(tag, name) != 0) {
+        return -1;
+    }
+    return tag;
+}
+
+logger_logTag_t logger_findTag(const char *name) {
+    if (_logger_tagHashSize == 0 || name == NULL) {
+        return -1;
+    }
+    return _logger_tagHash[_logger_tagSlot(name)];
+}
+
+const char *logger_getTagName(logger_logTag_t tag) {
+    if (tag < 0 || tag >= _logger_tagNameCount || _logger_tagNames[tag] == NULL) {
+        return NULL;
+    }
+    return _logger_tagNames[tag];
+}
+
+void logger_freeTags() {
+    for (int tag = 0; tag < _logger_tagNameCount; tag++) {
+        free(_logger_tagNames[tag]);
+    }
+    free(_logger_tagNames);
+    free(_logger_tagHash);
+    _logger_tagNames = NULL;
+    _logger_tagHash = NULL;
+    _logger_tagNameCount = 0;
+    _logger_tagNameUsed = 0;
+    _logger_tagHashSize = 0;
+}
+
+// Tag names used by an export. Tags of logDef take precedence over the registry.
+typedef struct {
+    const char **names;
+    int count;
+} _logger_names_t;
+
+static _logger_names_t _logger_resolveNames(logger_tagDef_t *logDef, int logDefCount) {
+    _logger_names_t names;
+    if (logDef == NULL) {
+        logDefCount = 0;
+    }
+    names.count = _logger_tagNameCount;
+    for (int k = 0; k < logDefCount; k++) {
+        if (logDef[k].tag >= names.count) {
+            names.count = logDef[k].tag + 1;
+        }
+    }
+    names.names = (const char **)calloc(names.count + 1, sizeof(const char *));
+    for (int tag = 0; tag < _logger_tagNameCount; tag++) {
+        names.names[tag] = _logger_tagNames[tag];
+    }
+    for (int k = 0; k < logDefCount; k++) {
+        if (logDef[k].tag >= 0) {
+            names.names[logDef[k].tag] = logDef[k].info;
+        }
+    }
+    return names;
+}
+
+static inline const char *_logger_tagInfo(const _logger_names_t *names, logger_logTag_t tag) {
+    if (tag < 0 || tag >= names->count || names->names[tag] == NULL) {
+        return "";
+    }
+    return names->names[tag];
+}
+
 unsigned long _log10(unsigned long v) {
     return (v >= 10000000000000000000u)  ? 19
            : (v >= 1000000000000000000u) ? 18
@@ -231,22 +1220,146 @@ int logger_writeToCSV(const char *fileName, logger_tagDef_t *logDef, int logDefC
     return logger_writeListToCSV(fileName, NULL, -1, logDef, logDefCount);
 }
 
-int __compare(void const *lhs, void const *rhs) {
-    double left = *(double *)lhs;
-    double right = *(double *)rhs;
-    if (left > right)
-        return 1;
-    else if (left < right)
-        return -1;
-    else
+// Hash map from an id to the timestamp and CPU of an entry. It is used to match the START and END entries of the
+// evaluations in O(1) instead of searching all lists for every START entry.
+typedef struct {
+    unsigned long *ids;
+    int64_t *times;
+    int *cpus;
+    char *used;
+    long size;
+    long count;
+} _logger_idMap_t;
+
+static void _logger_idMapFree(_logger_idMap_t *map) {
+    free(map->ids);
+    free(map->times);
+    free(map->cpus);
+    free(map->used);
+    memset(map, 0, sizeof(_logger_idMap_t));
+}
+
+static inline long _logger_idMapSlot(const _logger_idMap_t *map, unsigned long id) {
+    long slot = (long)(((uint64_t)id * 0x9E3779B97F4A7C15ull) & (uint64_t)(map->size - 1));
+    while (map->used[slot] && map->ids[slot] != id) {
+        slot = (slot + 1) & (map->size - 1);
+    }
+    return slot;
+}
+
+static void _logger_idMapResize(_logger_idMap_t *map, long size) {
+    _logger_idMap_t old = *map;
+    map->ids = (unsigned long *)malloc(sizeof(unsigned long) * size);
+    map->times = (int64_t *)malloc(sizeof(int64_t) * size);
+    map->cpus = (int *)malloc(sizeof(int) * size);
+    map->used = (char *)calloc(size, 1);
+    map->size = size;
+    map->count = 0;
+    for (long i = 0; i < old.size; i++) {
+        if (old.used[i]) {
+            long slot = _logger_idMapSlot(map, old.ids[i]);
+            map->used[slot] = 1;
+            map->ids[slot] = old.ids[i];
+            map->times[slot] = old.times[i];
+            map->cpus[slot] = old.cpus[i];
+            map->count++;
+        }
+    }
+    _logger_idMapFree(&old);
+}
+
+// Inserts or replaces the entry of an id.
+static void _logger_idMapPut(_logger_idMap_t *map, unsigned long id, int64_t time, int cpu) {
+    if ((map->count + 1) * 2 > map->size) {
+        _logger_idMapResize(map, map->size == 0 ? 1024 : map->size * 2);
+    }
+    long slot = _logger_idMapSlot(map, id);
+    if (!map->used[slot]) {
+        map->used[slot] = 1;
+        map->ids[slot] = id;
+        map->count++;
+    }
+    map->times[slot] = time;
+    map->cpus[slot] = cpu;
+}
+
+static int _logger_idMapGet(const _logger_idMap_t *map, unsigned long id, int64_t *time, int *cpu) {
+    if (map->size == 0) {
         return 0;
+    }
+    long slot = _logger_idMapSlot(map, id);
+    if (!map->used[slot]) {
+        return 0;
+    }
+    *time = map->times[slot];
+    *cpu = map->cpus[slot];
+    return 1;
 }
 
+static void _logger_idMapRemove(_logger_idMap_t *map, unsigned long id) {
+    if (map->size == 0) {
+        return;
+    }
+    long slot = _logger_idMapSlot(map, id);
+    if (!map->used[slot]) {
+        return;
+    }
+    // Backward shift deletion keeps the probe sequences intact
+    map->used[slot] = 0;
+    map->count--;
+    long next = (slot + 1) & (map->size - 1);
+    while (map->used[next]) {
+        long home = (long)(((uint64_t)map->ids[next] * 0x9E3779B97F4A7C15ull) & (uint64_t)(map->size - 1));
+        if (((next - home) & (map->size - 1)) >= ((next - slot) & (map->size - 1))) {
+            map->ids[slot] = map->ids[next];
+            map->times[slot] = map->times[next];
+            map->cpus[slot] = map->cpus[next];
+            map->used[slot] = 1;
+            map->used[next] = 0;
+            slot = next;
+        }
+        next = (next + 1) & (map->size - 1);
+    }
+}
+
+// Collects the END entries of a tag by id. Only the first END of an id in list order is kept, which is the entry the
+// evaluations match with every START entry of that id.
+static void _logger_collectEnds(_logger_idMap_t *ends, logger_logTag_t tage) {
+    for (int k = 0; k < _logger_config.listCount; k++) {
+        _logger_listIter_t it;
+        logger_logEntry_t entry;
+        int64_t time;
+        int cpu;
+        _logger_iterInit(&it, k);
+        while (_logger_iterNext(&it, &entry)) {
+            if (entry.tag == tage && !_logger_idMapGet(ends, entry.id, &time, &cpu)) {
+                _logger_idMapPut(ends, entry.id, _logger_timespecToNs(entry.time_stamp), entry.cpu);
+            }
+        }
+    }
+}
+
+// Spans of a tag pair that started on one CPU
+typedef struct {
+    size_t count;
+    size_t migrated;
+    double min;
+    double max;
+    double sum;
+} _logger_cpuStats_t;
+
 int logger_evaluate(logger_tagPair_t *pairList, int pairListCount, logger_tagDef_t *logDef, int logDefCount,
                     const char *csv_filename, const char *json_filename) {
 #define DIFFSIZE 1000
     FILE *pCsvFile = NULL;
     FILE *pJsonFile = NULL;
+    // The sampling columns are only written when a tag pair is sampled, so the CSV layout without sampling is unchanged
+    int sampled = 0;
+    for (int k = 0; k < _logger_sampleStateCount; k++) {
+        if (_logger_sampleState[k].mode != LSAMPLE_ALL) {
+            sampled = 1;
+        }
+    }
     if (csv_filename != NULL) {
         pCsvFile = fopen(csv_filename, "w");
         if (!pCsvFile) {
@@ -254,7 +1367,8 @@ int logger_evaluate(logger_tagPair_t *pairList, int pairListCount, logger_tagDef
             return -2;
         }
         fprintf(pCsvFile, "\n");
-        fprintf(pCsvFile, "TAGS;COUNT;MIN;MAX;AVG;MEDIAN\n");
+        fprintf(pCsvFile, "TAGS;COUNT;MIN;MAX;AVG;MEDIAN%s%s\n", sampled ? ";SAMPLING;EST_COUNT;RATE" : "",
+                _logger_config.recordCpu ? ";MIGRATED" : "");
     }
     if (json_filename != NULL) {
         pJsonFile = fopen(json_filename, "w");
@@ -265,6 +1379,11 @@ int logger_evaluate(logger_tagPair_t *pairList, int pairListCount, logger_tagDef
         fprintf(pJsonFile, "\n");
         fprintf(pJsonFile, "{\"data\":[\n");
     }
+    _logger_names_t names = _logger_resolveNames(logDef, logDefCount);
+    // The per CPU rows of all pairs follow the main table of the CSV file
+    _logger_cpuStats_t **pairCpus = (_logger_cpuStats_t **)calloc(pairListCount > 0 ? pairListCount : 1,
+                                                                  sizeof(_logger_cpuStats_t *));
+    int *pairCpuCounts = (int *)calloc(pairListCount > 0 ? pairListCount : 1, sizeof(int));
     for (int c = 0; c < pairListCount; c++) {
         logger_logTag_t tags = pairList[c].tag_start;
         logger_logTag_t tage = pairList[c].tag_end;
@@ -272,72 +1391,140 @@ int logger_evaluate(logger_tagPair_t *pairList, int pairListCount, logger_tagDef
         double mean = 0.0;
         double min = FLT_MAX;
         size_t count = 0;
+        struct timespec first = {0, 0};
+        struct timespec last = {0, 0};
         unsigned int median_list_size = 1000;
         double *median_list = (double *)malloc(median_list_size * sizeof(double));
+        // Only used with recordCpu. The spans are counted for the CPU of their START entry.
+        size_t migrated = 0;
+        _logger_cpuStats_t *cpus = NULL;
+        int cpuCount = 0;
 
+        _logger_idMap_t ends;
+        memset(&ends, 0, sizeof(ends));
+        _logger_collectEnds(&ends, tage);
         for (int j = 0; j < _logger_config.listCount; j++) {
-            for (int i = 0; i < _logger_nextEntry[j]; i++) {
-                logger_logEntry_t it1_entry = _logger_logEntryList[j * _logger_config.listSize + i];
-                bool it2_isBreak = false;
-                if (it1_entry.tag == tags) {
-                    for (int k = 0; k < _logger_config.listCount; k++) {
-                        for (int l = 0; l < _logger_nextEntry[k]; l++) {
-                            logger_logEntry_t it2_entry = _logger_logEntryList[k * _logger_config.listSize + l];
-                            if (it2_entry.tag == tage && it1_entry.id == it2_entry.id) {
-                                struct timespec diff = logger_elapsedTime(it1_entry.time_stamp, it2_entry.time_stamp);
-                                double diff_ms = logger_timespecToFloat_ms(diff);
-                                // min
-                                if (diff_ms < min) {
-                                    min = diff_ms;
-                                }
-                                // max
-                                if (diff_ms > max) {
-                                    max = diff_ms;
-                                }
-                                // mean
-                                mean += diff_ms;
-                                // median
-                                median_list[count] = diff_ms;
-
-                                // loop control and counter
-                                count += 1;
-                                if (count >= median_list_size) {
-                                    median_list_size *= 2;
-                                    median_list = realloc(median_list, median_list_size * sizeof(double));
-                                }
-                                it2_isBreak = true;
-                                break;
-                            }
+            _logger_listIter_t it1;
+            logger_logEntry_t it1_entry;
+            _logger_iterInit(&it1, j);
+            while (_logger_iterNext(&it1, &it1_entry)) {
+                int64_t endNs;
+                int endCpu;
+                if (it1_entry.tag == tags && _logger_idMapGet(&ends, it1_entry.id, &endNs, &endCpu)) {
+                    struct timespec diff = _logger_nsToTimespec(endNs - _logger_timespecToNs(it1_entry.time_stamp));
+                    double diff_ms = logger_timespecToFloat_ms(diff);
+                    // min
+                    if (diff_ms < min) {
+                        min = diff_ms;
+                    }
+                    // max
+                    if (diff_ms > max) {
+                        max = diff_ms;
+                    }
+                    // mean
+                    mean += diff_ms;
+                    // median
+                    median_list[count] = diff_ms;
+                    // observed time range for the rate
+                    if (count == 0 || logger_cmpTime(it1_entry.time_stamp, first) < 0) {
+                        first = it1_entry.time_stamp;
+                    }
+                    if (count == 0 || logger_cmpTime(it1_entry.time_stamp, last) > 0) {
+                        last = it1_entry.time_stamp;
+                    }
+                    // per CPU and migrations between START and END
+                    if (_logger_config.recordCpu && it1_entry.cpu >= 0) {
+                        if (it1_entry.cpu >= cpuCount) {
+                            cpus = (_logger_cpuStats_t *)realloc(cpus,
+                                                                 sizeof(_logger_cpuStats_t) * (it1_entry.cpu + 1));
+                            memset(&cpus[cpuCount], 0, sizeof(_logger_cpuStats_t) * (it1_entry.cpu + 1 - cpuCount));
+                            cpuCount = it1_entry.cpu + 1;
                         }
-                        if (it2_isBreak) break;
+                        _logger_cpuStats_t *cpu = &cpus[it1_entry.cpu];
+                        if (cpu->count == 0 || diff_ms < cpu->min) cpu->min = diff_ms;
+                        if (cpu->count == 0 || diff_ms > cpu->max) cpu->max = diff_ms;
+                        cpu->sum += diff_ms;
+                        cpu->count++;
+                        if (endCpu >= 0 && endCpu != it1_entry.cpu) {
+                            cpu->migrated++;
+                            migrated++;
+                        }
+                    }
+
+                    // counter
+                    count += 1;
+                    if (count >= median_list_size) {
+                        median_list_size *= 2;
+                        median_list = realloc(median_list, median_list_size * sizeof(double));
                     }
                 }
             }
         }
+        _logger_idMapFree(&ends);
+
+        // A pair without spans is reported with zeros
+        if (count == 0) {
+            min = 0.0;
+        } else {
+            mean /= count;
+        }
 
         // Evaluate median
-        qsort(median_list, count, sizeof(double), __compare);
+        qsort(median_list, count, sizeof(double), _logger_compareDouble);
         size_t mid = count / 2U;
-        double median = (count % 2 != 0) ? median_list[mid] : (median_list[mid] + median_list[mid - 1]) / 2.0;
+        double median = (count == 0)       ? 0.0
+                        : (count % 2 != 0) ? median_list[mid]
+                                           : (median_list[mid] + median_list[mid - 1]) / 2.0;
         free(median_list);
 
-        char infos[LOGGER_TAG_INFO_MAXLEN] = "";
-        char infoe[LOGGER_TAG_INFO_MAXLEN] = "";
-        for (int k = 0; k < logDefCount; k++) {
-            if (tags == logDef[k].tag) {
-                strncpy(infos, logDef[k].info, LOGGER_TAG_INFO_MAXLEN);
-            }
-            if (tage == logDef[k].tag) {
-                strncpy(infoe, logDef[k].info, LOGGER_TAG_INFO_MAXLEN);
+        // Correct the count and rate by the measured sampling factor
+        double sampling = 1.0;
+        for (int k = 0; k < _logger_sampleStateCount; k++) {
+            if (_logger_sampleState[k].pair.tag_start == tags && _logger_sampleState[k].pair.tag_end == tage &&
+                _logger_sampleState[k].mode != LSAMPLE_ALL) {
+                unsigned long seen = 0;
+                unsigned long kept = 0;
+                for (int l = 0; l < _logger_config.listCount; l++) {
+                    seen += _logger_sampleList[l * _logger_sampleStateCount + k].seen;
+                    kept += _logger_sampleList[l * _logger_sampleStateCount + k].kept;
+                }
+                if (kept > 0) {
+                    sampling = (double)seen / (double)kept;
+                }
             }
         }
+        double estCount = (double)count * sampling;
+        double duration_ms = logger_timespecToFloat_ms(logger_elapsedTime(first, last));
+        double rate = duration_ms > 0.0 ? estCount / duration_ms * 1000.0 : 0.0;
+
+        const char *infos = _logger_tagInfo(&names, tags);
+        const char *infoe = _logger_tagInfo(&names, tage);
         if (csv_filename == NULL && json_filename == NULL) {
-            printf("%s-%s | Count:%lu Min:%.5fms Max:%.5fms Mean:%.5fms Median:%.5fms\n", infos, infoe, count, min, max,
-                   mean / count, median);
+            printf("%s-%s | Count:%lu Min:%.5fms Max:%.5fms Mean:%.5fms Median:%.5fms", infos, infoe, count, min, max,
+                   mean, median);
+            if (sampling != 1.0) {
+                printf(" Sampling:%.2f EstCount:%.0f Rate:%.2f/s", sampling, estCount, rate);
+            }
+            if (_logger_config.recordCpu) {
+                printf(" Migrated:%lu", migrated);
+            }
+            printf("\n");
+            for (int k = 0; k < cpuCount; k++) {
+                if (cpus[k].count > 0) {
+                    printf("  CPU%d | Count:%lu Min:%.5fms Max:%.5fms Mean:%.5fms Migrated:%lu\n", k, cpus[k].count,
+                           cpus[k].min, cpus[k].max, cpus[k].sum / cpus[k].count, cpus[k].migrated);
+                }
+            }
         }
         if (csv_filename != NULL) {
-            fprintf(pCsvFile, "%s-%s;%lu;%.10f;%.10f;%.10f;%.10f\n", infos, infoe, count, min, max, mean / count,
-                    median);
+            fprintf(pCsvFile, "%s-%s;%lu;%.10f;%.10f;%.10f;%.10f", infos, infoe, count, min, max, mean, median);
+            if (sampled) {
+                fprintf(pCsvFile, ";%.5f;%.0f;%.5f", sampling, estCount, rate);
+            }
+            if (_logger_config.recordCpu) {
+                fprintf(pCsvFile, ";%lu", migrated);
+            }
+            fprintf(pCsvFile, "\n");
         }
         if (json_filename != NULL) {
             fprintf(pJsonFile, "\t{\n");
@@ -345,18 +1532,65 @@ int logger_evaluate(logger_tagPair_t *pairList, int pairListCount, logger_tagDef
             fprintf(pJsonFile, "\t\t\"count\":%lu,\n", count);
             fprintf(pJsonFile, "\t\t\"min\":%.10f,\n", min);
             fprintf(pJsonFile, "\t\t\"max\":%.10f,\n", max);
-            fprintf(pJsonFile, "\t\t\"mean\":%.10f,\n", mean / count);
-            fprintf(pJsonFile, "\t\t\"median\":%.10f\n", median);
-            fprintf(pJsonFile, "\t}");
+            fprintf(pJsonFile, "\t\t\"mean\":%.10f,\n", mean);
+            fprintf(pJsonFile, "\t\t\"median\":%.10f", median);
+            // Like the CSV columns, the keys of sampling and recordCpu are only written when they are active
+            if (sampled) {
+                fprintf(pJsonFile, ",\n\t\t\"sampling\":%.5f,\n", sampling);
+                fprintf(pJsonFile, "\t\t\"est_count\":%.0f,\n", estCount);
+                fprintf(pJsonFile, "\t\t\"rate\":%.5f", rate);
+            }
+            if (_logger_config.recordCpu) {
+                fprintf(pJsonFile, ",\n\t\t\"migrated\":%lu,\n", migrated);
+                fprintf(pJsonFile, "\t\t\"cpus\":[");
+                int firstCpu = 1;
+                for (int k = 0; k < cpuCount; k++) {
+                    if (cpus[k].count > 0) {
+                        fprintf(pJsonFile,
+                                "%s\n\t\t\t{\"cpu\":%d,\"count\":%lu,\"min\":%.10f,\"max\":%.10f,\"mean\":%.10f,"
+                                "\"migrated\":%lu}",
+                                firstCpu ? "" : ",", k, cpus[k].count, cpus[k].min, cpus[k].max,
+                                cpus[k].sum / cpus[k].count, cpus[k].migrated);
+                        firstCpu = 0;
+                    }
+                }
+                fprintf(pJsonFile, "%s]", firstCpu ? "" : "\n\t\t");
+            }
+            fprintf(pJsonFile, "\n\t}");
             if (c < (pairListCount - 1)) fprintf(pJsonFile, ",");
             fprintf(pJsonFile, "\n");
         }
+        pairCpus[c] = cpus;
+        pairCpuCounts[c] = cpuCount;
+    }
+    if (csv_filename != NULL) {
+        // Second table: one row per pair and CPU of the START entry
+        if (_logger_config.recordCpu) {
+            fprintf(pCsvFile, "\nTAGS;CPU;COUNT;MIN;MAX;AVG;MIGRATED\n");
+            for (int c = 0; c < pairListCount; c++) {
+                for (int k = 0; k < pairCpuCounts[c]; k++) {
+                    _logger_cpuStats_t *cpu = &pairCpus[c][k];
+                    if (cpu->count > 0) {
+                        fprintf(pCsvFile, "%s-%s;%d;%lu;%.10f;%.10f;%.10f;%lu\n",
+                                _logger_tagInfo(&names, pairList[c].tag_start),
+                                _logger_tagInfo(&names, pairList[c].tag_end), k, cpu->count, cpu->min, cpu->max,
+                                cpu->sum / cpu->count, cpu->migrated);
+                    }
+                }
+            }
+        }
+        fclose(pCsvFile);
+    }
+    for (int c = 0; c < pairListCount; c++) {
+        free(pairCpus[c]);
     }
-    if (csv_filename != NULL) fclose(pCsvFile);
+    free(pairCpus);
+    free(pairCpuCounts);
     if (json_filename != NULL) {
         fprintf(pJsonFile, "]}");
         fclose(pJsonFile);
     }
+    free(names.names);
     return 0;
 }
 
@@ -370,49 +1604,227 @@ int logger_evaluate_diff(logger_tagPair_t *pairList, int pairListCount, logger_t
             return -2;
         }
         fprintf(pFile, "\n");
-        fprintf(pFile, "TAGS;DIFF\n");
+        fprintf(pFile, "TAGS;DIFF%s\n", _logger_config.recordCpu ? ";START_CPU;END_CPU;MIGRATED" : "");
     }
+    _logger_names_t names = _logger_resolveNames(logDef, logDefCount);
     for (int c = 0; c < pairListCount; c++) {
         logger_logTag_t tags = pairList[c].tag_start;
         logger_logTag_t tage = pairList[c].tag_end;
-
+        const char *infos = _logger_tagInfo(&names, tags);
+        const char *infoe = _logger_tagInfo(&names, tage);
+        _logger_idMap_t ends;
+        memset(&ends, 0, sizeof(ends));
+        _logger_collectEnds(&ends, tage);
         for (int j = 0; j < _logger_config.listCount; j++) {
-            for (int i = 0; i < _logger_nextEntry[j]; i++) {
-                logger_logEntry_t it1_entry = _logger_logEntryList[j * _logger_config.listSize + i];
-                bool it2_isBreak = false;
-                if (it1_entry.tag == tags) {
-                    for (int k = 0; k < _logger_config.listCount; k++) {
-                        for (int l = 0; l < _logger_nextEntry[k]; l++) {
-                            logger_logEntry_t it2_entry = _logger_logEntryList[k * _logger_config.listSize + l];
-                            if (it2_entry.tag == tage && it1_entry.id == it2_entry.id) {
-                                struct timespec diff = logger_elapsedTime(it1_entry.time_stamp, it2_entry.time_stamp);
-                                double diff_ms = logger_timespecToFloat_ms(diff);
-                                char infos[LOGGER_TAG_INFO_MAXLEN] = "";
-                                char infoe[LOGGER_TAG_INFO_MAXLEN] = "";
-                                for (int k = 0; k < logDefCount; k++) {
-                                    if (tags == logDef[k].tag) {
-                                        strncpy(infos, logDef[k].info, LOGGER_TAG_INFO_MAXLEN);
-                                    }
-                                    if (tage == logDef[k].tag) {
-                                        strncpy(infoe, logDef[k].info, LOGGER_TAG_INFO_MAXLEN);
-                                    }
-                                }
-                                if (csv_filename == NULL) {
-                                    printf("%s-%s: %.12f\n", infos, infoe, diff_ms);
-                                } else {
-                                    fprintf(pFile, "%s;%s;%.12f\n", infos, infoe, diff_ms);
-                                }
-                                it2_isBreak = true;
-                                break;
-                            }
+            _logger_listIter_t it1;
+            logger_logEntry_t it1_entry;
+            _logger_iterInit(&it1, j);
+            while (_logger_iterNext(&it1, &it1_entry)) {
+                int64_t endNs;
+                int endCpu;
+                if (it1_entry.tag == tags && _logger_idMapGet(&ends, it1_entry.id, &endNs, &endCpu)) {
+                    struct timespec diff = _logger_nsToTimespec(endNs - _logger_timespecToNs(it1_entry.time_stamp));
+                    double diff_ms = logger_timespecToFloat_ms(diff);
+                    // A span migrated when its END entry was written on another CPU than its START entry
+                    int migrated = it1_entry.cpu >= 0 && endCpu >= 0 && endCpu != it1_entry.cpu;
+                    if (csv_filename == NULL) {
+                        printf("%s-%s: %.12f", infos, infoe, diff_ms);
+                        if (_logger_config.recordCpu) {
+                            printf(" CPU:%d->%d%s", it1_entry.cpu, endCpu, migrated ? " migrated" : "");
+                        }
+                        printf("\n");
+                    } else {
+                        fprintf(pFile, "%s;%s;%.12f", infos, infoe, diff_ms);
+                        if (_logger_config.recordCpu) {
+                            fprintf(pFile, ";%d;%d;%d", it1_entry.cpu, endCpu, migrated);
                         }
-                        if (it2_isBreak) break;
+                        fprintf(pFile, "\n");
                     }
                 }
             }
         }
+        _logger_idMapFree(&ends);
     }
     if (csv_filename != NULL) fclose(pFile);
+    free(names.names);
+    return 0;
+}
+
+static int64_t _logger_floorDiv(int64_t a, int64_t b) { return a / b - ((a % b != 0) && ((a < 0) != (b < 0))); }
+
+// Offset from the clock of the logger to the wall clock (Unix time) in nanoseconds, sampled now. Returns -1, when the
+// clock has no fixed offset to the wall clock.
+static int _logger_wallOffset(int64_t *offset) {
+    struct timespec now;
+    struct timespec wall;
+    logger_clockType_t type = _logger_config.clockType;
+#ifdef WIN
+    if (type == LCLOCK_WIN_AFILEDATE) {
+        *offset = 0;
+        return 0;
+    }
+    if (type != LCLOCK_WIN_QUERYPERFCOUNTER) {
+        return -1;
+    }
+    _getTime(&now, type);
+    clock_getAsFileTime(&wall);
+#elif defined(__linux__)
+    if (type == LCLOCK_LINUX_TIMEOFDAY) {
+        *offset = 0;
+        return 0;
+    }
+    if (type != LCLOCK_LINUX_REALTIME) {
+        return -1;
+    }
+    _getTime(&now, type);
+    clock_gettime(CLOCK_REALTIME, &wall);
+#else
+    return -1;
+#endif
+    *offset = _logger_timespecToNs(wall) - _logger_timespecToNs(now);
+    return 0;
+}
+
+// Formats a time in nanoseconds as <seconds>.<nanoseconds with 9 digits>
+static void _logger_formatNs(char *buffer, size_t size, int64_t ns) {
+    long long sec = (long long)_logger_floorDiv(ns, 1000000000LL);
+    snprintf(buffer, size, "%lld.%09lld", sec, (long long)(ns - sec * 1000000000LL));
+}
+
+int logger_evaluate_windowed(logger_tagPair_t *pairList, int pairListCount, int64_t windowNs,
+                             logger_tagDef_t *logDef, int logDefCount, const char *csv_filename,
+                             const char *json_filename) {
+    if (windowNs <= 0) {
+        printf("[Error] Invalid window\n");
+        return -1;
+    }
+    FILE *pCsvFile = NULL;
+    FILE *pJsonFile = NULL;
+    if (csv_filename != NULL) {
+        pCsvFile = fopen(csv_filename, "w");
+        if (!pCsvFile) {
+            printf("[Error] Could not open files: %s\n", strerror(errno));
+            return -2;
+        }
+        fprintf(pCsvFile, "TAGS;WINDOW_START;WALL_START;COUNT;MIN;MAX;P50;P99\n");
+    }
+    int64_t wallOffset = 0;
+    int hasWall = _logger_wallOffset(&wallOffset) == 0;
+    if (json_filename != NULL) {
+        pJsonFile = fopen(json_filename, "w");
+        if (!pJsonFile) {
+            printf("[Error] Could not open files: %s\n", strerror(errno));
+            if (pCsvFile != NULL) fclose(pCsvFile);
+            return -2;
+        }
+        fprintf(pJsonFile, "{\"window_ns\":%lld,", (long long)windowNs);
+        if (hasWall) {
+            fprintf(pJsonFile, "\"realtime_offset_ns\":%lld,", (long long)wallOffset);
+        }
+        fprintf(pJsonFile, "\"data\":[\n");
+    }
+    _logger_names_t names = _logger_resolveNames(logDef, logDefCount);
+    _logger_idMap_t *open = (_logger_idMap_t *)calloc((size_t)pairListCount + 1, sizeof(_logger_idMap_t));
+    _logger_windowMap_t *windows =
+        (_logger_windowMap_t *)calloc((size_t)pairListCount + 1, sizeof(_logger_windowMap_t));
+
+    // One pass over the entries of all lists in time order, so a span is matched when it ends, also across lists
+    int listCount = _logger_config.listCount;
+    _logger_listIter_t *its = (_logger_listIter_t *)malloc(sizeof(_logger_listIter_t) * (size_t)(listCount + 1));
+    logger_logEntry_t *heads = (logger_logEntry_t *)malloc(sizeof(logger_logEntry_t) * (size_t)(listCount + 1));
+    char *valid = (char *)malloc((size_t)listCount + 1);
+    for (int j = 0; j < listCount; j++) {
+        _logger_iterInit(&its[j], j);
+        valid[j] = (char)_logger_iterNext(&its[j], &heads[j]);
+    }
+    for (;;) {
+        int next = -1;
+        int64_t time = 0;
+        for (int j = 0; j < listCount; j++) {
+            if (valid[j] && (next < 0 || _logger_timespecToNs(heads[j].time_stamp) < time)) {
+                next = j;
+                time = _logger_timespecToNs(heads[j].time_stamp);
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+        const logger_logEntry_t *entry = &heads[next];
+        for (int c = 0; c < pairListCount; c++) {
+            int64_t start;
+            int cpu;
+            if (entry->tag == pairList[c].tag_start) {
+                _logger_idMapPut(&open[c], entry->id, time, entry->cpu);
+            } else if (entry->tag == pairList[c].tag_end && _logger_idMapGet(&open[c], entry->id, &start, &cpu)) {
+                _logger_idMapRemove(&open[c], entry->id);
+                _logger_histAdd(_logger_windowGet(&windows[c], _logger_floorDiv(start, windowNs)), time - start);
+            }
+        }
+        valid[next] = (char)_logger_iterNext(&its[next], &heads[next]);
+    }
+    free(its);
+    free(heads);
+    free(valid);
+
+    for (int c = 0; c < pairListCount; c++) {
+        const char *infos = _logger_tagInfo(&names, pairList[c].tag_start);
+        const char *infoe = _logger_tagInfo(&names, pairList[c].tag_end);
+        if (pJsonFile != NULL) {
+            fprintf(pJsonFile, "\t{\n");
+            fprintf(pJsonFile, "\t\t\"name\":\"%s-%s\",\n", infos, infoe);
+            fprintf(pJsonFile, "\t\t\"windows\":[\n");
+        }
+        // The windows with spans in time order
+        _logger_windowMap_t *map = &windows[c];
+        long count = map->count;
+        int64_t *order = _logger_windowOrder(map);
+        for (long w = 0; w < count; w++) {
+            const _logger_hist_t *hist = &map->hists[_logger_windowSlot(map, order[w])];
+            char start[32];
+            char wall[32] = "";
+            _logger_formatNs(start, sizeof(start), order[w] * windowNs);
+            if (hasWall) {
+                _logger_formatNs(wall, sizeof(wall), order[w] * windowNs + wallOffset);
+            }
+            double min = (double)hist->min / 1e6;
+            double max = (double)hist->max / 1e6;
+            double p50 = (double)_logger_histQuantile(hist, 0.5) / 1e6;
+            double p99 = (double)_logger_histQuantile(hist, 0.99) / 1e6;
+            if (csv_filename == NULL && json_filename == NULL) {
+                printf("%s-%s | Window:%s Wall:%s Count:%lu Min:%.5fms Max:%.5fms P50:%.5fms P99:%.5fms\n", infos,
+                       infoe, start, hasWall ? wall : "-", (unsigned long)hist->count, min, max, p50, p99);
+            }
+            if (pCsvFile != NULL) {
+                fprintf(pCsvFile, "%s-%s;%s;%s;%lu;%.10f;%.10f;%.10f;%.10f\n", infos, infoe, start, wall,
+                        (unsigned long)hist->count, min, max, p50, p99);
+            }
+            if (pJsonFile != NULL) {
+                fprintf(pJsonFile, "\t\t\t{\"start\":%s,", start);
+                if (hasWall) {
+                    fprintf(pJsonFile, "\"wall_start\":%s,", wall);
+                }
+                fprintf(pJsonFile, "\"count\":%lu,\"min\":%.10f,\"max\":%.10f,\"p50\":%.10f,\"p99\":%.10f}%s\n",
+                        (unsigned long)hist->count, min, max, p50, p99, w < count - 1 ? "," : "");
+            }
+        }
+        free(order);
+        if (pJsonFile != NULL) {
+            fprintf(pJsonFile, "\t\t]\n");
+            fprintf(pJsonFile, "\t}");
+            if (c < (pairListCount - 1)) fprintf(pJsonFile, ",");
+            fprintf(pJsonFile, "\n");
+        }
+        _logger_windowMapFree(map);
+        _logger_idMapFree(&open[c]);
+    }
+    free(windows);
+    free(open);
+    if (pCsvFile != NULL) fclose(pCsvFile);
+    if (pJsonFile != NULL) {
+        fprintf(pJsonFile, "]}");
+        fclose(pJsonFile);
+    }
+    free(names.names);
     return 0;
 }
 
@@ -433,7 +1845,7 @@ int logger_writeListToCSV(const char *fileName, int *exportList, int exportListC
         printf("[Error] Could not open files\n");
         return -2;
     }
-    fprintf(pFile, "\n");
+    _logger_names_t names = _logger_resolveNames(logDef, logDefCount);
     long startTime = INT_MAX;
     for (int j = 0; j < _logger_config.listCount; j++) {
         if (exportOnlySpecificLists) {
@@ -448,11 +1860,25 @@ int logger_writeListToCSV(const char *fileName, int *exportList, int exportListC
                 continue;
             }
         }
-        if (_logger_logEntryList[j * _logger_config.listSize].time_stamp.tv_sec > 0 &&
-            _logger_logEntryList[j * _logger_config.listSize].time_stamp.tv_sec < startTime) {
-            startTime = (long)_logger_logEntryList[j * _logger_config.listSize].time_stamp.tv_sec;
+        _logger_listIter_t it;
+        logger_logEntry_t first;
+        _logger_iterInit(&it, j);
+        if (_logger_iterNext(&it, &first) && first.time_stamp.tv_sec > 0 && first.time_stamp.tv_sec < startTime) {
+            startTime = (long)first.time_stamp.tv_sec;
         }
     }
+    if (startTime == INT_MAX) {
+        startTime = 0;
+    }
+#ifdef WIN
+    long pid = (long)GetCurrentProcessId();
+#else
+    long pid = (long)getpid();
+#endif
+    // The timestamps are relative to base_sec. It keeps the absolute time base, so captures of different processes
+    // can be merged.
+    fprintf(pFile, "#rtperflog;version=%d;clock=%d;base_sec=%ld;pid=%ld\n", LOGGER_CSV_VERSION,
+            (int)_logger_config.clockType, startTime, pid);
 
     for (int j = 0; j < _logger_config.listCount; j++) {
         if (exportOnlySpecificLists) {
@@ -467,32 +1893,216 @@ int logger_writeListToCSV(const char *fileName, int *exportList, int exportListC
                 continue;
             }
         }
-        for (int i = 0; i < _logger_nextEntry[j]; i++) {
-            logger_logEntry_t *lEntr = &_logger_logEntryList[j * _logger_config.listSize + i];
+        _logger_listIter_t it;
+        logger_logEntry_t entry;
+        logger_logEntry_t *lEntr = &entry;
+        _logger_iterInit(&it, j);
+        while (_logger_iterNext(&it, &entry)) {
             int stellen = _log10(lEntr->time_stamp.tv_nsec);
             int restZeros = 8 - stellen;
             char zeroString[9] = "";
             for (int j = 0; j < restZeros; j++) {
                 strcat(zeroString, "0");
             }
-            char info[LOGGER_TAG_INFO_MAXLEN] = "";
-            for (int k = 0; k < logDefCount; k++) {
-                if (lEntr->tag == logDef[k].tag) {
-                    strncpy(info, logDef[k].info, LOGGER_TAG_INFO_MAXLEN);
-                    break;
-                }
+            fprintf(pFile, "%s,%lu,%d.%s%ld", _logger_tagInfo(&names, lEntr->tag), lEntr->id,
+                    (int)(lEntr->time_stamp.tv_sec - startTime), zeroString, lEntr->time_stamp.tv_nsec);
+            if (_logger_config.recordCpu) {
+                fprintf(pFile, ",%d", lEntr->cpu);
             }
-            fprintf(pFile, "%s,%lu,%d.%s%ld\n", info, lEntr->id, (int)(lEntr->time_stamp.tv_sec - startTime),
-                    zeroString, lEntr->time_stamp.tv_nsec);
+            fprintf(pFile, "\n");
         }
     }
 
     fclose(pFile);
+    free(names.names);
+    return 0;
+}
+
+int logger_writeToBinary(const char *fileName, logger_tagDef_t *logDef, int logDefCount) {
+    if (_logger_config.listCount == 0) {
+        printf("[Error] No List allocated\n");
+        return -1;
+    }
+    FILE *pFile = fopen(fileName, "wb");
+    if (!pFile) {
+        printf("[Error] Could not open files: %s\n", strerror(errno));
+        return -2;
+    }
+    _logger_fileHeader_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LOGGER_FILE_MAGIC, sizeof(header.magic));
+    header.version = LOGGER_FILE_VERSION;
+    header.clockType = _logger_config.clockType;
+    _logger_names_t names = _logger_resolveNames(logDef, logDefCount);
+    for (int tag = 0; tag < names.count; tag++) {
+        header.tagCount += names.names[tag] != NULL;
+    }
+    for (int j = 0; j < _logger_config.listCount; j++) {
+        header.entryCount += logger_getEntryCount(j);
+    }
+    fwrite(&header, sizeof(header), 1, pFile);
+    for (int k = 0; k < names.count; k++) {
+        if (names.names[k] == NULL) {
+            continue;
+        }
+        _logger_fileTag_t tag;
+        memset(&tag, 0, sizeof(tag));
+        tag.tag = k;
+        strncpy(tag.info, names.names[k], LOGGER_TAG_INFO_MAXLEN - 1);
+        fwrite(&tag, sizeof(tag), 1, pFile);
+    }
+    free(names.names);
+    for (int j = 0; j < _logger_config.listCount; j++) {
+        _logger_listIter_t it;
+        logger_logEntry_t entry;
+        _logger_iterInit(&it, j);
+        while (_logger_iterNext(&it, &entry)) {
+            _logger_fileEntry_t rec;
+            rec.tag = entry.tag;
+            rec.list = j;
+            rec.id = entry.id;
+            rec.time = _logger_timespecToNs(entry.time_stamp);
+            rec.cpu = entry.cpu;
+            rec.reserved = 0;
+            fwrite(&rec, sizeof(rec), 1, pFile);
+        }
+    }
+    if (fclose(pFile) != 0) {
+        return -2;
+    }
+    return 0;
+}
+
+int logger_addOutlierRecorder(logger_tagPair_t pair, int k, int64_t windowNs, int contextSize) {
+    if (pair.tag_start < 0 || pair.tag_end < 0 || k <= 0 || contextSize < 0 || _logger_config.listCount <= 0) {
+        return -1;
+    }
+    _logger_growTagState(pair.tag_start > pair.tag_end ? pair.tag_start : pair.tag_end);
+#ifndef WIN
+    if (_logger_outlierState != NULL) {
+        munlock(_logger_outlierState, sizeof(_logger_outlierState_t) * _logger_outlierStateCount);
+    }
+#endif
+    _logger_outlierState = (_logger_outlierState_t *)realloc(
+        _logger_outlierState, sizeof(_logger_outlierState_t) * (_logger_outlierStateCount + 1));
+    _logger_outlierState_t *state = &_logger_outlierState[_logger_outlierStateCount];
+    memset(state, 0, sizeof(_logger_outlierState_t));
+    state->pair = pair;
+    state->k = k;
+    state->window = windowNs;
+    state->contextSize = contextSize;
+    state->heap = (_logger_outlierSpan_t *)calloc(k, sizeof(_logger_outlierSpan_t));
+    state->context = (_logger_ctxEntry_t *)calloc((size_t)k * contextSize + 1, sizeof(_logger_ctxEntry_t));
+    state->contextCount = (int *)calloc(k, sizeof(int));
+    state->contextGen = (unsigned int *)calloc(k, sizeof(unsigned int));
+    state->pending = (_logger_pendingSpan_t *)calloc(2 * (size_t)k, sizeof(_logger_pendingSpan_t));
+    state->lists = (_logger_ctxList_t *)calloc(_logger_config.listCount, sizeof(_logger_ctxList_t));
+#ifndef WIN
+    int ret = mlock(state->heap, sizeof(_logger_outlierSpan_t) * k);
+    ret += mlock(state->context, sizeof(_logger_ctxEntry_t) * k * contextSize);
+    ret += mlock(state->contextCount, sizeof(int) * k);
+    ret += mlock(state->contextGen, sizeof(unsigned int) * k);
+    ret += mlock(state->pending, sizeof(_logger_pendingSpan_t) * 2 * k);
+    ret += mlock(state->lists, sizeof(_logger_ctxList_t) * _logger_config.listCount);
+    ret += mlock(_logger_outlierState, sizeof(_logger_outlierState_t) * (_logger_outlierStateCount + 1));
+#endif
+    _logger_tagState[pair.tag_start].outlier = _logger_outlierStateCount;
+    _logger_tagState[pair.tag_start].isStart = 1;
+    _logger_tagState[pair.tag_end].outlier = _logger_outlierStateCount;
+    _logger_tagState[pair.tag_end].isStart = 0;
+    _logger_outlierStateCount++;
+    return 0;
+}
+
+static int __compareSpan(void const *lhs, void const *rhs) {
+    const _logger_outlierSpan_t *left = (const _logger_outlierSpan_t *)lhs;
+    const _logger_outlierSpan_t *right = (const _logger_outlierSpan_t *)rhs;
+    int64_t l = left->end - left->start;
+    int64_t r = right->end - right->start;
+    return (l < r) ? 1 : (l > r) ? -1 : 0;
+}
+
+static int __compareCtx(void const *lhs, void const *rhs) {
+    const _logger_ctxEntry_t *left = (const _logger_ctxEntry_t *)lhs;
+    const _logger_ctxEntry_t *right = (const _logger_ctxEntry_t *)rhs;
+    return logger_cmpTime(left->entry.time_stamp, right->entry.time_stamp);
+}
+
+int logger_writeOutlierReport(const char *fileName, logger_tagDef_t *logDef, int logDefCount) {
+    FILE *pFile = stdout;
+    if (fileName != NULL) {
+        pFile = fopen(fileName, "w");
+        if (!pFile) {
+            printf("[Error] Could not open files: %s\n", strerror(errno));
+            return -2;
+        }
+    }
+    fprintf(pFile, "\n");
+    fprintf(pFile, "RANK;TAGS;ID;DURATION;SPANS;START_CPU;END_CPU\n");
+    fprintf(pFile, "CONTEXT;LIST;TAG;ID;OFFSET;CPU\n");
+    fprintf(pFile, "DROPPED;TAGS;COUNT;OPEN_LIMIT\n");
+    _logger_names_t names = _logger_resolveNames(logDef, logDefCount);
+    for (int r = 0; r < _logger_outlierStateCount; r++) {
+        _logger_outlierState_t *state = &_logger_outlierState[r];
+        // The context of the spans whose window has not passed yet is copied with what is available
+        while (state->pendingCount > 0) {
+            _logger_pendingSpan_t *pending = &state->pending[state->pendingHead];
+            if (pending->gen == state->contextGen[pending->span.ctx]) {
+                _logger_copyContext(state, &pending->span);
+            }
+            _logger_popPending(state);
+        }
+        const char *infos = _logger_tagInfo(&names, state->pair.tag_start);
+        const char *infoe = _logger_tagInfo(&names, state->pair.tag_end);
+        // START entries that were dropped, because more than LOGGER_OUTLIER_OPEN spans were open
+        if (state->dropped > 0) {
+            fprintf(pFile, "DROPPED;%s-%s;%lu;%d\n", infos, infoe, state->dropped, LOGGER_OUTLIER_OPEN);
+        }
+        _logger_outlierSpan_t *spans = (_logger_outlierSpan_t *)malloc(sizeof(_logger_outlierSpan_t) * state->k);
+        memcpy(spans, state->heap, sizeof(_logger_outlierSpan_t) * state->count);
+        qsort(spans, state->count, sizeof(_logger_outlierSpan_t), __compareSpan);
+        for (int i = 0; i < state->count; i++) {
+            _logger_outlierSpan_t *span = &spans[i];
+            fprintf(pFile, "%d;%s-%s;%lu;%.10f;%lu;%d;%d\n", i + 1, infos, infoe, span->id,
+                    (double)(span->end - span->start) / 1e6, state->seen, span->startCpu, span->endCpu);
+            _logger_ctxEntry_t *ctx = &state->context[(size_t)span->ctx * state->contextSize];
+            int ctxCount = state->contextCount[span->ctx];
+            qsort(ctx, ctxCount, sizeof(_logger_ctxEntry_t), __compareCtx);
+            for (int c = 0; c < ctxCount; c++) {
+                fprintf(pFile, "CONTEXT;%d;%s;%lu;%.10f;%d\n", ctx[c].list, _logger_tagInfo(&names, ctx[c].entry.tag),
+                        ctx[c].entry.id, (double)(_logger_timespecToNs(ctx[c].entry.time_stamp) - span->start) / 1e6,
+                        ctx[c].entry.cpu);
+            }
+        }
+        free(spans);
+    }
+    free(names.names);
+    if (fileName != NULL) fclose(pFile);
     return 0;
 }
 
 int *logger_getErrorCount() { return _logger_errorCount; }
 
+int logger_getEntryCount(int listNumber) {
+    if (listNumber < 0 || listNumber >= _logger_config.listCount) {
+        return -1;
+    }
+    if (_logger_ringWrapped[listNumber]) {
+        return _logger_config.listSize;
+    }
+    return _logger_nextEntry[listNumber];
+}
+
+long logger_getListMemUsage(int listNumber) {
+    if (listNumber < 0 || listNumber >= _logger_config.listCount) {
+        return -1;
+    }
+    if (_logger_config.listMode == LLIST_COMPRESSED) {
+        return (long)_logger_blockState[listNumber].block * LOGGER_BLOCK_SIZE + _logger_blockState[listNumber].offset;
+    }
+    return (long)logger_getEntryCount(listNumber) * (long)sizeof(logger_logEntry_t);
+}
+
 struct timespec logger_elapsedTime(struct timespec start, struct timespec end) {
     struct timespec temp;
     if ((end.tv_nsec - start.tv_nsec) < 0) {
@@ -531,8 +2141,49 @@ float logger_timespecToFloat_ms(struct timespec time) {
 void logger_clear() {
 #ifndef WIN
     munlock(_logger_nextEntry, sizeof(int) * _logger_config.listCount);
-    munlock(_logger_logEntryList, sizeof(logger_logEntry_t) * _logger_config.listSize * _logger_config.listCount);
+    if (_logger_config.listMode == LLIST_COMPRESSED) {
+        munlock(_logger_blockList, (size_t)LOGGER_BLOCK_SIZE * _logger_config.listSize * _logger_config.listCount);
+        munlock(_logger_blockState, sizeof(_logger_blockState_t) * _logger_config.listCount);
+    } else {
+        munlock(_logger_logEntryList, sizeof(logger_logEntry_t) * _logger_config.listSize * _logger_config.listCount);
+    }
+    munlock(_logger_ringWrapped, sizeof(char) * _logger_config.listCount);
+    for (int i = 0; i < _logger_outlierStateCount; i++) {
+        _logger_outlierState_t *state = &_logger_outlierState[i];
+        munlock(state->heap, sizeof(_logger_outlierSpan_t) * state->k);
+        munlock(state->context, sizeof(_logger_ctxEntry_t) * state->k * state->contextSize);
+        munlock(state->contextCount, sizeof(int) * state->k);
+        munlock(state->contextGen, sizeof(unsigned int) * state->k);
+        munlock(state->pending, sizeof(_logger_pendingSpan_t) * 2 * state->k);
+        munlock(state->lists, sizeof(_logger_ctxList_t) * _logger_config.listCount);
+    }
+    if (_logger_outlierState != NULL) {
+        munlock(_logger_outlierState, sizeof(_logger_outlierState_t) * _logger_outlierStateCount);
+    }
+    munlock(_logger_writeCount, sizeof(int64_t) * _logger_config.listCount);
+    if (_logger_sampleList != NULL) {
+        munlock(_logger_sampleList,
+                sizeof(_logger_sampleList_t) * _logger_sampleStateCount * _logger_config.listCount);
+    }
 #endif
-    free(_logger_nextEntry);
-    free(_logger_logEntryList);
+    for (int i = 0; i < _logger_outlierStateCount; i++) {
+        free(_logger_outlierState[i].heap);
+        free(_logger_outlierState[i].context);
+        free(_logger_outlierState[i].contextCount);
+        free(_logger_outlierState[i].contextGen);
+        free(_logger_outlierState[i].pending);
+        free(_logger_outlierState[i].lists);
+    }
+    free(_logger_outlierState);
+    _logger_outlierState = NULL;
+    _logger_outlierStateCount = 0;
+    _logger_freeLists();
+    free(_logger_tagState);
+    free(_logger_sampleState);
+    free(_logger_sampleList);
+    _logger_sampleList = NULL;
+    _logger_tagState = NULL;
+    _logger_tagStateCount = 0;
+    _logger_sampleState = NULL;
+    _logger_sampleStateCount = 0;
 }
\ No newline at end of file
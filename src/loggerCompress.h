@@ -0,0 +1,93 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains the block format of the compressed list mode.
+ */
+
+#ifndef LOGGERCOMPRESS_H
+#define LOGGERCOMPRESS_H
+#include <stdint.h>
+#include <string.h>
+
+// A compressed list is a sequence of LOGGER_BLOCK_SIZE byte blocks. Each block starts with a uint16 entry count
+// followed by the entries. An entry is stored as three zigzag varints: tag delta, id delta and timestamp delta (in ns)
+// to the previous entry of the same block. With recordCpu a fourth varint holds the CPU delta. The first entry of a
+// block is stored relative to zero, so every block can be decoded on its own.
+#define LOGGER_BLOCK_HEADER 2
+// Worst case size of one entry: 5 bytes tag + 10 bytes id + 10 bytes time, plus 5 bytes cpu with recordCpu.
+#define LOGGER_ENTRY_MAXENC 25
+#define LOGGER_CPU_MAXENC 5
+
+// Write state of a compressed list.
+typedef struct {
+    int block;
+    int offset;
+    int64_t lastTag;
+    uint64_t lastId;
+    int64_t lastTime;
+    int64_t lastCpu;
+} _logger_blockState_t;
+
+static inline uint64_t _logger_zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+
+static inline int64_t _logger_unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+static inline int _logger_putVarint(unsigned char *buf, uint64_t v) {
+    int n = 0;
+    while (v >= 0x80) {
+        buf[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    buf[n++] = (unsigned char)v;
+    return n;
+}
+
+static inline int _logger_getVarint(const unsigned char *buf, uint64_t *v) {
+    int n = 0;
+    int shift = 0;
+    uint64_t res = 0;
+    while (buf[n] & 0x80) {
+        res |= (uint64_t)(buf[n++] & 0x7f) << shift;
+        shift += 7;
+    }
+    res |= (uint64_t)buf[n++] << shift;
+    *v = res;
+    return n;
+}
+
+static inline uint16_t _logger_blockCount(const unsigned char *block) {
+    uint16_t count;
+    memcpy(&count, block, sizeof(count));
+    return count;
+}
+
+static inline void _logger_setBlockCount(unsigned char *block, uint16_t count) {
+    memcpy(block, &count, sizeof(count));
+}
+
+static inline int64_t _logger_timespecToNs(struct timespec time) {
+    return (int64_t)time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+static inline struct timespec _logger_nsToTimespec(int64_t ns) {
+    struct timespec time;
+    time.tv_sec = ns / 1000000000LL;
+    time.tv_nsec = ns % 1000000000LL;
+    if (time.tv_nsec < 0) {
+        time.tv_sec--;
+        time.tv_nsec += 1000000000LL;
+    }
+    return time;
+}
+
+#endif  // LOGGERCOMPRESS_H
@@ -0,0 +1,62 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains the binary capture format, which is shared by the logger and the tools.
+ */
+
+#ifndef LOGGERFORMAT_H
+#define LOGGERFORMAT_H
+#include <stdint.h>
+
+#include "logger.h"
+
+// A binary capture consists of a header, headerTagCount tag records and headerEntryCount entry records. All values
+// are stored in host byte order. Timestamps are absolute nanoseconds of the clock given in the header.
+// Version 2 appends the cpu (-1 = not recorded) to the entry record of version 1, which is still readable.
+#define LOGGER_FILE_MAGIC "RTPL"
+#define LOGGER_FILE_VERSION 2
+
+// Version of the CSV layout, which is written to the metadata line of a CSV export. It is independent of the binary
+// capture format. Rows are TAG,ID,TIME with the CPU as optional fourth and the list as optional fifth column.
+#define LOGGER_CSV_VERSION 1
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    int32_t clockType;
+    int32_t tagCount;
+    int64_t entryCount;
+} _logger_fileHeader_t;
+
+typedef struct {
+    int32_t tag;
+    char info[LOGGER_TAG_INFO_MAXLEN];
+} _logger_fileTag_t;
+
+typedef struct {
+    int32_t tag;
+    int32_t list;
+    uint64_t id;
+    int64_t time;
+    int32_t cpu;
+    int32_t reserved;
+} _logger_fileEntry_t;
+
+typedef struct {
+    int32_t tag;
+    int32_t list;
+    uint64_t id;
+    int64_t time;
+} _logger_fileEntryV1_t;
+
+#endif  // LOGGERFORMAT_H
@@ -0,0 +1,195 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains the log-linear latency histogram and the sparse map of window histograms, which are
+ *               shared by the logger and the tools.
+ */
+
+#ifndef LOGGERHIST_H
+#define LOGGERHIST_H
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Values below 2^LOGGER_HIST_SUB_BITS ns are counted exactly. Above, every power of two is split into
+// 2^(LOGGER_HIST_SUB_BITS-1) buckets, so the relative error of a quantile is below 1/64. Values of
+// 2^LOGGER_HIST_MAX_BITS ns (about 18 minutes) and more are counted in the last bucket.
+#define LOGGER_HIST_SUB_BITS 7
+#define LOGGER_HIST_SUB (1 << LOGGER_HIST_SUB_BITS)
+#define LOGGER_HIST_MAX_BITS 40
+#define LOGGER_HIST_ROWS (LOGGER_HIST_MAX_BITS - LOGGER_HIST_SUB_BITS + 1)
+
+/**
+ * A histogram of durations in nanoseconds. The rows of buckets are allocated on first use, so a histogram of a narrow
+ * distribution only needs a few kB. Count, min, max and sum are exact.
+ */
+typedef struct {
+    uint64_t count;
+    int64_t min;
+    int64_t max;
+    double sum;
+    uint64_t *rows[LOGGER_HIST_ROWS];
+} _logger_hist_t;
+
+static inline void _logger_histInit(_logger_hist_t *hist) { memset(hist, 0, sizeof(_logger_hist_t)); }
+
+static inline void _logger_histFree(_logger_hist_t *hist) {
+    for (int r = 0; r < LOGGER_HIST_ROWS; r++) {
+        free(hist->rows[r]);
+    }
+    memset(hist, 0, sizeof(_logger_hist_t));
+}
+
+static inline int _logger_histMsb(uint64_t value) {
+    int msb = 0;
+    for (int shift = 32; shift > 0; shift >>= 1) {
+        if (value >> shift) {
+            value >>= shift;
+            msb += shift;
+        }
+    }
+    return msb;
+}
+
+static inline void _logger_histAdd(_logger_hist_t *hist, int64_t ns) {
+    if (hist->count == 0 || ns < hist->min) hist->min = ns;
+    if (hist->count == 0 || ns > hist->max) hist->max = ns;
+    hist->count++;
+    hist->sum += (double)ns;
+
+    uint64_t value = ns < 0 ? 0 : (uint64_t)ns;
+    int row = 0;
+    int sub = 0;
+    if (value >= ((uint64_t)1 << LOGGER_HIST_MAX_BITS)) {
+        row = LOGGER_HIST_ROWS - 1;
+        sub = LOGGER_HIST_SUB - 1;
+    } else if (value >= LOGGER_HIST_SUB) {
+        row = _logger_histMsb(value) - LOGGER_HIST_SUB_BITS + 1;
+        sub = (int)(value >> row);
+    } else {
+        sub = (int)value;
+    }
+    if (hist->rows[row] == NULL) {
+        hist->rows[row] = (uint64_t *)calloc(LOGGER_HIST_SUB, sizeof(uint64_t));
+    }
+    hist->rows[row][sub]++;
+}
+
+/**
+ * Returns the value of the quantile p (0..1) in nanoseconds. It is the center of the bucket of the rank, limited to
+ * min and max.
+ */
+static inline int64_t _logger_histQuantile(const _logger_hist_t *hist, double p) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(p * (double)(hist->count - 1) + 0.5);
+    uint64_t seen = 0;
+    for (int r = 0; r < LOGGER_HIST_ROWS; r++) {
+        if (hist->rows[r] == NULL) {
+            continue;
+        }
+        for (int s = 0; s < LOGGER_HIST_SUB; s++) {
+            seen += hist->rows[r][s];
+            if (seen > rank) {
+                int64_t value = r == 0 ? (int64_t)s : ((int64_t)s << r) + ((int64_t)1 << (r - 1));
+                if (value < hist->min) value = hist->min;
+                if (value > hist->max) value = hist->max;
+                return value;
+            }
+        }
+    }
+    return hist->max;
+}
+
+// Histograms of the windows of a tag pair by window index. Only windows with spans take memory.
+typedef struct {
+    int64_t *windows;
+    _logger_hist_t *hists;
+    char *used;
+    long size;
+    long count;
+} _logger_windowMap_t;
+
+static inline void _logger_windowMapFree(_logger_windowMap_t *map) {
+    for (long i = 0; i < map->size; i++) {
+        if (map->used[i]) {
+            _logger_histFree(&map->hists[i]);
+        }
+    }
+    free(map->windows);
+    free(map->hists);
+    free(map->used);
+    memset(map, 0, sizeof(_logger_windowMap_t));
+}
+
+static inline long _logger_windowSlot(const _logger_windowMap_t *map, int64_t window) {
+    long slot = (long)(((uint64_t)window * 0x9E3779B97F4A7C15ull) >> 20 & (uint64_t)(map->size - 1));
+    while (map->used[slot] && map->windows[slot] != window) {
+        slot = (slot + 1) & (map->size - 1);
+    }
+    return slot;
+}
+
+// Returns the histogram of a window. It is created on first use.
+static inline _logger_hist_t *_logger_windowGet(_logger_windowMap_t *map, int64_t window) {
+    if ((map->count + 1) * 2 > map->size) {
+        _logger_windowMap_t old = *map;
+        map->size = old.size == 0 ? 64 : old.size * 2;
+        map->count = 0;
+        map->windows = (int64_t *)malloc(sizeof(int64_t) * map->size);
+        map->hists = (_logger_hist_t *)malloc(sizeof(_logger_hist_t) * map->size);
+        map->used = (char *)calloc(map->size, 1);
+        for (long i = 0; i < old.size; i++) {
+            if (old.used[i]) {
+                long slot = _logger_windowSlot(map, old.windows[i]);
+                map->used[slot] = 1;
+                map->windows[slot] = old.windows[i];
+                map->hists[slot] = old.hists[i];
+                map->count++;
+            }
+        }
+        free(old.windows);
+        free(old.hists);
+        free(old.used);
+    }
+    long slot = _logger_windowSlot(map, window);
+    if (!map->used[slot]) {
+        map->used[slot] = 1;
+        map->windows[slot] = window;
+        _logger_histInit(&map->hists[slot]);
+        map->count++;
+    }
+    return &map->hists[slot];
+}
+
+static inline int _logger_compareWindow(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Returns the indexes of the windows with spans in time order. The array of map->count entries must be freed.
+static inline int64_t *_logger_windowOrder(const _logger_windowMap_t *map) {
+    int64_t *order = (int64_t *)malloc(sizeof(int64_t) * (size_t)(map->count + 1));
+    long count = 0;
+    for (long i = 0; i < map->size; i++) {
+        if (map->used[i]) {
+            order[count++] = map->windows[i];
+        }
+    }
+    qsort(order, (size_t)count, sizeof(int64_t), _logger_compareWindow);
+    return order;
+}
+
+#endif  // LOGGERHIST_H
@@ -17,10 +17,122 @@
 #ifndef LOGGERMEM_H
 #define LOGGERMEM_H
 #include "logger.h"
+#include "loggerCompress.h"
 // To store the logger results, static variables are used, so that an mem initialization must be called only once and
 // not per compilation unit.
 static logger_logEntry_t *_logger_logEntryList;
 static int *_logger_nextEntry;
 static logger_config_t _logger_config;
 static int *_logger_errorCount;
+// Only used in LLIST_RING mode. Set when the write position of a list wrapped around.
+static char *_logger_ringWrapped;
+// Only used in LLIST_PLAIN and LLIST_RING mode. Count of all entries written to a list. It is published after the entry
+// is complete, so the outlier recorders can read the lists of other threads while they are written.
+static int64_t *_logger_writeCount;
+// Only used in LLIST_COMPRESSED mode
+static unsigned char *_logger_blockList;
+static _logger_blockState_t *_logger_blockState;
+
+// Sampling configuration of a tag pair. It is shared by the start and the end tag.
+typedef struct {
+    logger_tagPair_t pair;
+    logger_sampleMode_t mode;
+    uint64_t param;
+} _logger_sampleState_t;
+
+// Sampling state of a tag pair in one list. Each list is written by one thread only, so the probes need no locks.
+typedef struct {
+    unsigned long seen;
+    unsigned long kept;
+    int64_t nextTime;
+    unsigned long openId;
+    int open;
+} _logger_sampleList_t;
+
+// Count of open spans an outlier recorder can track at the same time. Must be a power of two.
+#define LOGGER_OUTLIER_OPEN 64
+
+typedef struct {
+    logger_logEntry_t entry;
+    int list;
+} _logger_ctxEntry_t;
+
+typedef struct {
+    unsigned long id;
+    int64_t start;
+    int64_t end;
+    int ctx;
+    int startCpu;
+    int endCpu;
+} _logger_outlierSpan_t;
+
+typedef struct {
+    unsigned long id;
+    int64_t start;
+    int used;
+    int cpu;
+} _logger_openSpan_t;
+
+// A span whose context is copied once its time window has passed. It is stale when the context region of the span
+// was given to another span in the meantime, i.e. gen differs from the generation of the region.
+typedef struct {
+    _logger_outlierSpan_t span;
+    unsigned int gen;
+} _logger_pendingSpan_t;
+
+// Part of a list that lies in the time window of a context copy. first is the sequence number of the first entry in
+// the window (LLIST_COMPRESSED: the first block to decode, last the last one). count is capped at the context size + 1
+// for compressed lists. budget is the count of entries to copy.
+typedef struct {
+    int64_t first;
+    int64_t last;
+    int64_t count;
+    int budget;
+} _logger_ctxList_t;
+
+// State of an outlier recorder. heap is a min-heap of the k longest spans. Each span owns a fixed region of
+// contextSize entries in context, which is filled once the time window after the span has passed. open is a hash map
+// with linear probing of the spans that are started but not ended. pending is a FIFO of 2 * k spans.
+typedef struct {
+    logger_tagPair_t pair;
+    int k;
+    int count;
+    int64_t window;
+    int contextSize;
+    unsigned long seen;
+    unsigned long dropped;
+    _logger_outlierSpan_t *heap;
+    _logger_ctxEntry_t *context;
+    int *contextCount;
+    unsigned int *contextGen;
+    _logger_openSpan_t open[LOGGER_OUTLIER_OPEN];
+    _logger_pendingSpan_t *pending;
+    int pendingHead;
+    int pendingCount;
+    _logger_ctxList_t *lists;
+} _logger_outlierState_t;
+
+// Per tag lookup table, indexed by the tag. sample and outlier are indices into _logger_sampleState and
+// _logger_outlierState or -1.
+typedef struct {
+    int sample;
+    int outlier;
+    int isStart;
+} _logger_tagState_t;
+
+static _logger_tagState_t *_logger_tagState;
+static int _logger_tagStateCount;
+static _logger_sampleState_t *_logger_sampleState;
+static int _logger_sampleStateCount;
+// Indexed by list * _logger_sampleStateCount + sample
+static _logger_sampleList_t *_logger_sampleList;
+static _logger_outlierState_t *_logger_outlierState;
+static int _logger_outlierStateCount;
+
+// Tag registry. _logger_tagNames is indexed by the tag, _logger_tagHash maps the hash of a name to its tag.
+static char **_logger_tagNames;
+static int _logger_tagNameCount;
+static int _logger_tagNameUsed;
+static int *_logger_tagHash;
+static int _logger_tagHashSize;
 #endif  // LOGGERMEM_H
\ No newline at end of file
@@ -0,0 +1,38 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains small helpers, which are shared by the logger and the tools.
+ */
+
+#ifndef LOGGERUTIL_H
+#define LOGGERUTIL_H
+#include <stdint.h>
+
+// FNV-1a hash of a tag name
+static inline uint64_t _logger_hashName(const char *name) {
+    uint64_t hash = 14695981039346656037ull;
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// qsort comparison of doubles in ascending order
+static inline int _logger_compareDouble(void const *lhs, void const *rhs) {
+    double left = *(const double *)lhs;
+    double right = *(const double *)rhs;
+    return (left > right) ? 1 : (left < right) ? -1 : 0;
+}
+
+#endif  // LOGGERUTIL_H
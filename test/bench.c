@@ -0,0 +1,159 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains some benchmarks for rtPerfLog
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+
+#define TAGS(TAG) TAG(TAG_CYCLE) TAG(TAG_READ) TAG(TAG_CONTROL) TAG(TAG_WRITE)
+
+GENERATE_DEF(TAGS)
+
+#define BENCH_CYCLES 100000
+#define BENCH_LISTSIZE (BENCH_CYCLES * TAG_COUNT)
+
+static logger_config_t makeConfig(logger_listMode_t mode) {
+    logger_config_t conf = {0};
+#ifdef WIN
+    conf.clockType = LCLOCK_WIN_QUERYPERFCOUNTER;
+#else
+    conf.clockType = LCLOCK_LINUX_REALTIME;
+#endif
+    conf.listCount = 1;
+    conf.listMode = mode;
+    // Both modes get the same amount of memory
+    conf.listSize = mode == LLIST_COMPRESSED ? BENCH_LISTSIZE * (int)sizeof(logger_logEntry_t) / LOGGER_BLOCK_SIZE
+                                             : BENCH_LISTSIZE;
+    return conf;
+}
+
+static double elapsedNs(struct timespec start, struct timespec end) {
+    struct timespec diff = logger_elapsedTime(start, end);
+    return (double)diff.tv_sec * 1e9 + (double)diff.tv_nsec;
+}
+
+// A 1kHz control cycle with read, control and write phases and some jitter, as recorded on a real-time system.
+static void recordTrace(void) {
+    struct timespec now;
+    logger_getTime(&now);
+    long t = (long)now.tv_sec * 1000000000L + now.tv_nsec;
+    srand(42);
+    for (long i = 0; i < BENCH_CYCLES; i++) {
+        long cycle = t + i * 1000000L + rand() % 20000;
+        long phase = cycle + 2000 + rand() % 500;
+        struct timespec ts;
+        ts.tv_sec = cycle / 1000000000L;
+        ts.tv_nsec = cycle % 1000000000L;
+        logger_addLogEntryCustTime(TAG_CYCLE_START, i, 0, ts);
+        // The phases are the pairs after TAG_CYCLE
+        for (int pair = 1; pair < evalListFullSize; pair++) {
+            ts.tv_sec = phase / 1000000000L;
+            ts.tv_nsec = phase % 1000000000L;
+            logger_addLogEntryCustTime(evalListFull[pair].tag_start, i, 0, ts);
+            phase += 10000 + rand() % 5000;
+            ts.tv_sec = phase / 1000000000L;
+            ts.tv_nsec = phase % 1000000000L;
+            logger_addLogEntryCustTime(evalListFull[pair].tag_end, i, 0, ts);
+            phase += 500 + rand() % 200;
+        }
+        ts.tv_sec = phase / 1000000000L;
+        ts.tv_nsec = phase % 1000000000L;
+        logger_addLogEntryCustTime(TAG_CYCLE_END, i, 0, ts);
+    }
+}
+
+// Time per logger_addLogEntry call including the clock query.
+static double probeCost(void) {
+    struct timespec start, end;
+    logger_getTime(&start);
+    for (long i = 0; i < BENCH_CYCLES; i++) {
+        logger_addLogEntry(TAG_CYCLE_START, i, 0);
+        logger_addLogEntry(TAG_CYCLE_END, i, 0);
+    }
+    logger_getTime(&end);
+    return elapsedNs(start, end) / (2.0 * BENCH_CYCLES);
+}
+
+static void benchListMode(const char *name, logger_listMode_t mode, logger_tagDef_t *def) {
+    logger_init(makeConfig(mode));
+    recordTrace();
+    int entries = logger_getEntryCount(0);
+    long bytes = logger_getListMemUsage(0);
+    struct timespec start, end;
+    logger_getTime(&start);
+    logger_writeToCSV("bench.csv", def, TAG_COUNT);
+    logger_getTime(&end);
+    logger_reset();
+    double cost = probeCost();
+    logger_clear();
+    printf("%-10s | entries:%d bytes:%ld bytes/entry:%.2f ratio:%.2f | probe:%.1fns | export:%.2fms\n", name, entries,
+           bytes, (double)bytes / entries, (double)entries * sizeof(logger_logEntry_t) / bytes, cost,
+           elapsedNs(start, end) / 1e6);
+}
+
+// Time per logger_addLogEntry call for a sampled tag pair. Most of the probes are skipped.
+static void benchSampling(const char *name, logger_sampleMode_t mode, unsigned long param) {
+    logger_init(makeConfig(LLIST_PLAIN));
+    logger_tagPair_t pair = {TAG_CYCLE_START, TAG_CYCLE_END};
+    logger_setSampling(pair, mode, param);
+    double cost = probeCost();
+    printf("%-10s | entries:%d | probe:%.1fns\n", name, logger_getEntryCount(0), cost);
+    logger_clear();
+}
+
+// Time per logger_addLogEntry call for a tag pair with an outlier recorder on a ring list.
+static void benchOutlier(const char *name, int k, int contextSize) {
+    logger_config_t conf = makeConfig(LLIST_RING);
+    conf.listSize = 10000;
+    logger_init(conf);
+    logger_tagPair_t pair = {TAG_CYCLE_START, TAG_CYCLE_END};
+    logger_addOutlierRecorder(pair, k, 100000, contextSize);
+    double cost = probeCost();
+    printf("%-10s | entries:%d | probe:%.1fns\n", name, logger_getEntryCount(0), cost);
+    logger_clear();
+}
+
+// Time per logger_addLogEntry call with and without the CPU of every entry.
+static void benchRecordCpu(const char *name, logger_clockType_t clockType, int recordCpu) {
+    logger_config_t conf = makeConfig(LLIST_PLAIN);
+    conf.clockType = clockType;
+    conf.recordCpu = recordCpu;
+    logger_init(conf);
+    double cost = probeCost();
+    printf("%-10s | entries:%d | probe:%.1fns\n", name, logger_getEntryCount(0), cost);
+    logger_clear();
+}
+
+int main() {
+    logger_tagDef_t *def = makeLoggerDef();
+    benchListMode("plain", LLIST_PLAIN, def);
+    benchListMode("compressed", LLIST_COMPRESSED, def);
+    benchSampling("1-in-1000", LSAMPLE_ONE_IN_N, 1000);
+    benchSampling("1/100us", LSAMPLE_PERIOD, 100000);
+    benchOutlier("top-100", 100, 64);
+#ifndef WIN
+    benchRecordCpu("clock", LCLOCK_LINUX_REALTIME, 0);
+    benchRecordCpu("clock+cpu", LCLOCK_LINUX_REALTIME, 1);
+#if defined(__amd64__)
+    benchRecordCpu("tsc", LCLOCK_RDTSCP, 0);
+    benchRecordCpu("tsc+cpu", LCLOCK_RDTSCP, 1);
+#endif
+#endif
+    free(def);
+    logger_freeTags();
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file compares the cost of the C++ scoped spans with hand-written C probes, which use the same
+ * enum constants as tags. probeCppThread additionally reads the thread-local list binding once.
+ */
+#include <cstdio>
+
+#include "rtperflog.hpp"
+
+enum { TAG_WORK_START, TAG_WORK_END };
+RTPERFLOG_TAG(TAG_WORK, TAG_WORK_START, TAG_WORK_END);
+
+#define BENCH_CYCLES 1000000
+
+// The probes must not be inlined into the benchmark loop
+#if defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+static volatile long sink;
+
+BENCH_NOINLINE void probeC(long id) {
+    logger_addLogEntry(TAG_WORK_START, id, 0);
+    sink = id;
+    logger_addLogEntry(TAG_WORK_END, id, 0);
+}
+
+BENCH_NOINLINE void probeCpp(long id) {
+    rtperflog::ScopedSpan<TAG_WORK> span(id, 0);
+    sink = id;
+}
+
+// Same span, but the list is read from the thread binding
+BENCH_NOINLINE void probeCppThread(long id) {
+    RTPERFLOG_SPAN(TAG_WORK, id);
+    sink = id;
+}
+
+static double bench(void (*probe)(long)) {
+    logger_reset();
+    struct timespec start, end;
+    logger_getTime(&start);
+    for (long i = 0; i < BENCH_CYCLES; i++) {
+        probe(i);
+    }
+    logger_getTime(&end);
+    struct timespec diff = logger_elapsedTime(start, end);
+    return ((double)diff.tv_sec * 1e9 + (double)diff.tv_nsec) / BENCH_CYCLES;
+}
+
+int main() {
+    logger_config_t conf = {};
+#ifdef WIN
+    conf.clockType = LCLOCK_WIN_QUERYPERFCOUNTER;
+#else
+    conf.clockType = LCLOCK_LINUX_REALTIME;
+#endif
+    conf.listCount = 1;
+    conf.listSize = 2 * BENCH_CYCLES;
+    logger_init(conf);
+    if (rtperflog::registerTags<TAG_WORK>() != 0) {
+        return 1;
+    }
+    rtperflog::ListBinding binding(0);
+    // Warm up
+    bench(probeC);
+    double c = bench(probeC);
+    double cpp = bench(probeCpp);
+    double cppThread = bench(probeCppThread);
+    printf("C probes   | span:%.1fns\n", c);
+    printf("C++ spans  | span:%.1fns\n", cpp);
+    printf("C++ thread | span:%.1fns\n", cppThread);
+    logger_clear();
+    logger_freeTags();
+    return 0;
+}
@@ -13,12 +13,16 @@
  * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
  * @description: This file contains some test for rtPerfLog
  */
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "logger.h"
 #ifndef WIN
+#include <sched.h>
 #include <unistd.h>
 #else
 #include <windows.h>
@@ -28,9 +32,268 @@
 
 GENERATE_DEF(TAGS)
 
+// The tags are constant expressions
+static const logger_tagPair_t demoPair = {TAG_DEMO_START, TAG_DEMO_END};
+
+// testTags.c
+logger_tagDef_t *testTags_makeDef(int *count);
+logger_tagPair_t testTags_pair(void);
+
+// Reads a whole file and terminates it with a 0, so it can be parsed as a string. Returns its size or -1.
+static long readFile(const char *fileName, char **data) {
+    FILE *pFile = fopen(fileName, "rb");
+    if (!pFile) {
+        return -1;
+    }
+    fseek(pFile, 0, SEEK_END);
+    long size = ftell(pFile);
+    rewind(pFile);
+    *data = (char *)malloc(size + 1);
+    if (fread(*data, 1, size, pFile) != (size_t)size) {
+        size = -1;
+    } else {
+        (*data)[size] = '\0';
+    }
+    fclose(pFile);
+    return size;
+}
+
+// Returns 1 if the file contains the text, 0 if not and -1 if it could not be read
+static int fileContains(const char *fileName, const char *text) {
+    char *data = NULL;
+    if (readFile(fileName, &data) < 0) {
+        return -1;
+    }
+    int ret = strstr(data, text) != NULL;
+    free(data);
+    return ret;
+}
+
+// Reads a column of a row of a CSV report. The first line that is not empty is the header and the row is found by its
+// first column. Returns 0 if found, -1 if the row or the column is missing.
+static int csvValue(const char *fileName, const char *row, const char *column, double *value) {
+    char *data = NULL;
+    if (readFile(fileName, &data) < 0) {
+        return -1;
+    }
+    int header = 0;
+    int col = -1;
+    int ret = -1;
+    for (char *line = data, *next; line != NULL; line = next) {
+        next = strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        char *fields[16];
+        int count = 0;
+        for (char *f = line; f != NULL && count < 16; count++) {
+            fields[count] = f;
+            f = strchr(f, ';');
+            if (f != NULL) {
+                *f++ = '\0';
+            }
+        }
+        if (!header && fields[0][0] != '\0') {
+            header = 1;
+            for (int i = 0; i < count; i++) {
+                if (strcmp(fields[i], column) == 0) {
+                    col = i;
+                }
+            }
+        } else if (col >= 0 && col < count && strcmp(fields[0], row) == 0) {
+            *value = atof(fields[col]);
+            ret = 0;
+            break;
+        }
+    }
+    free(data);
+    return ret;
+}
+
+// Spans of about 1us with one span of 50us every 10000 spans
+static void recordOutliers(int count) {
+    struct timespec t = {1, 0};
+    for (int i = 0; i < count; i++) {
+        logger_addLogEntryCustTime(TAG_DEMO_START, i, 0, t);
+        t.tv_nsec += (i % 10000 == 5000) ? 50000 : 1000 + i % 7;
+        logger_addLogEntryCustTime(TAG_DEMO_END, i, 0, t);
+        t.tv_nsec += 1000;
+        if (t.tv_nsec >= 1000000000) {
+            t.tv_sec++;
+            t.tv_nsec -= 1000000000;
+        }
+    }
+}
+
+// Checks that an outlier report has the expected ranks of at least minDuration ms and that every rank has context
+// before and after its span. Returns 0 if it matches.
+static int checkOutliers(const char *fileName, int ranks, double minDuration, unsigned long spans) {
+    char *data = NULL;
+    if (readFile(fileName, &data) < 0) {
+        return -1;
+    }
+    int rank = 0;
+    int ret = 0;
+    int before = 1;
+    int after = 1;
+    double duration = 0.0;
+    for (char *line = data, *next; line != NULL; line = next) {
+        next = strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        unsigned long id;
+        unsigned long seen;
+        double offset;
+        if (sscanf(line, "%d;%*[^;];%lu;%lf;%lu", &rank, &id, &duration, &seen) == 4) {
+            if (!before || !after || duration < minDuration || seen != spans) {
+                ret = -1;
+            }
+            before = 0;
+            after = 0;
+        } else if (sscanf(line, "CONTEXT;%*d;%*[^;];%lu;%lf", &id, &offset) == 2) {
+            before |= offset < 0.0;
+            after |= offset > duration;
+        }
+    }
+    free(data);
+    return (ret == 0 && rank == ranks && before && after) ? 0 : -1;
+}
+
+// Checks the windows of 10 ms of TAG_DEMO over spans of 0.2 ms, which start every 1 ms from 100 s on. The spans of
+// windows 3-5 are missing. Returns 0 if the windows match.
+static int checkWindows(const char *fileName) {
+    char *data = NULL;
+    if (readFile(fileName, &data) < 0) {
+        return -1;
+    }
+    const int expected[] = {0, 1, 2, 6, 7, 8, 9};
+    int windows = 0;
+    int ret = 0;
+    double offset = 0.0;
+    for (char *line = data, *next; line != NULL; line = next) {
+        next = strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        double start;
+        double wall;
+        unsigned long count;
+        double min;
+        if (sscanf(line, "TAG_DEMO_START-TAG_DEMO_END;%lf;%lf;%lu;%lf", &start, &wall, &count, &min) != 4) {
+            continue;
+        }
+        if (windows == 0) {
+            offset = wall - start;
+        }
+        if (windows >= 7 || fabs(start - (100.0 + 0.01 * expected[windows])) > 1e-9 || count != 10 ||
+            fabs(min - 0.2) > 1e-9 || fabs(wall - start - offset) > 1e-6 || wall < 1e9) {
+            ret = -1;
+        }
+        windows++;
+    }
+    free(data);
+    return (ret == 0 && windows == 7) ? 0 : -1;
+}
+
+// Checks the CPUs of the 100 spans of TAG_DEMO in the reports of the CPU test. A span is flagged, when its START and
+// END entry ran on different CPUs, and the MIGRATED counts of both evaluation tables match the flags. known: the
+// platform reports CPUs. pinned: START ran on CPU 0 and END of every second span on CPU 1. Returns 0 if they match.
+static int checkCpus(int known, int pinned) {
+    char *data = NULL;
+    if (readFile("test_cpu_diff.csv", &data) < 0) {
+        return -1;
+    }
+    int spans = 0;
+    unsigned long migrated = 0;
+    int ret = 0;
+    for (char *line = data; line != NULL; line = strchr(line, '\n')) {
+        line += (*line == '\n');
+        double diff;
+        int startCpu;
+        int endCpu;
+        int flag;
+        if (sscanf(line, "TAG_DEMO_START;TAG_DEMO_END;%lf;%d;%d;%d", &diff, &startCpu, &endCpu, &flag) != 4) {
+            continue;
+        }
+        if (flag != (startCpu >= 0 && endCpu >= 0 && startCpu != endCpu) || (known && (startCpu < 0 || endCpu < 0)) ||
+            (pinned && (startCpu != 0 || endCpu != spans % 2))) {
+            ret = -1;
+        }
+        migrated += flag;
+        spans++;
+    }
+    free(data);
+    double total;
+    if (ret != 0 || spans != 100 || csvValue("test_cpu.csv", "TAG_DEMO_START-TAG_DEMO_END", "MIGRATED", &total) != 0 ||
+        (unsigned long)total != migrated || readFile("test_cpu.csv", &data) < 0) {
+        return -1;
+    }
+    // The per CPU table follows the main table after a blank line
+    char *table = strstr(data, "\n\nTAGS;CPU;COUNT;MIN;MAX;AVG;MIGRATED\n");
+    unsigned long count = 0;
+    unsigned long cpuMigrated = 0;
+    for (char *line = table; line != NULL; line = strchr(line, '\n')) {
+        line++;
+        int cpu;
+        unsigned long cpuCount;
+        double min;
+        double max;
+        double avg;
+        unsigned long flags;
+        if (sscanf(line, "TAG_DEMO_START-TAG_DEMO_END;%d;%lu;%lf;%lf;%lf;%lu", &cpu, &cpuCount, &min, &max, &avg,
+                   &flags) == 6) {
+            if (pinned && cpu != 0) {
+                ret = -1;
+            }
+            count += cpuCount;
+            cpuMigrated += flags;
+        }
+    }
+    free(data);
+    if (ret != 0 || table == NULL || count != (known ? 100UL : 0UL) || cpuMigrated != migrated ||
+        readFile("test_cpu_export.csv", &data) < 0) {
+        return -1;
+    }
+    // The export has the CPU as fourth column
+    int entries = 0;
+    for (char *line = data; line != NULL; line = strchr(line, '\n')) {
+        line += (*line == '\n');
+        unsigned long id;
+        double time;
+        int cpu;
+        if (sscanf(line, "TAG_DEMO_START,%lu,%lf,%d", &id, &time, &cpu) == 3) {
+            if ((known && cpu < 0) || (pinned && cpu != 0)) {
+                ret = -1;
+            }
+            entries++;
+        }
+    }
+    free(data);
+    return (ret == 0 && entries == 100) ? 0 : -1;
+}
+
+// Entries whose tag, id and time deltas are large, negative and wrap around
+static void recordRoundTrip(int count) {
+    int64_t ns = -5000000123LL;
+    for (int i = 0; i < count; i++) {
+        long id = (i % 3 == 0) ? LONG_MAX - i : (i % 3 == 1) ? LONG_MIN + i : -i;
+        logger_logTag_t tag = (i % 17 == 0) ? 100000 + i : (i * 7) % 5;
+        ns += (i % 10 == 0) ? -1500000000LL : 123457LL * (i % 13);
+        struct timespec t;
+        t.tv_sec = (time_t)(ns / 1000000000LL);
+        t.tv_nsec = (long)(ns % 1000000000LL);
+        if (t.tv_nsec < 0) {
+            t.tv_sec--;
+            t.tv_nsec += 1000000000L;
+        }
+        logger_addLogEntryCustTime(tag, id, 0, t);
+    }
+}
+
 int main() {
     logger_tagDef_t *def = makeLoggerDef();
-    logger_config_t conf;
+    logger_config_t conf = {0};
 #ifdef WIN
     conf.clockType = LCLOCK_WIN_QUERYPERFCOUNTER;
 #else
@@ -38,7 +301,19 @@ int main() {
 #endif
     conf.listCount = 1;
     conf.listSize = 100000;
-    logger_init(conf);
+    // Random values of a config that is not zero-initialized are rejected
+    logger_config_t invalid = conf;
+    invalid.recordCpu = 0x7f3a;
+    logger_config_t invalidMode = conf;
+    invalidMode.listMode = (logger_listMode_t)42;
+    if (logger_init(invalid) != -1 || logger_init(invalidMode) != -1) {
+        printf("[Error] Invalid config is accepted\n");
+        return 1;
+    }
+    if (logger_init(conf) < 0) {
+        printf("[Error] Could not init the logger\n");
+        return 1;
+    }
     struct timespec start, end;
 
     for (int i = 0; i < 1000; i++) {
@@ -56,9 +331,319 @@ int main() {
     }
     logger_evaluate(evalListFull, evalListFullSize, def, TAG_COUNT, NULL, NULL);
     logger_evaluate(evalListFull, evalListFullSize, def, TAG_COUNT, "test_eval.csv", "test_eval.json");
+    // Without sampling and recordCpu the JSON has no keys of them, like the CSV has no columns of them
+    if (fileContains("test_eval.json", "\"median\"") != 1 || fileContains("test_eval.json", "\"sampling\"") != 0 ||
+        fileContains("test_eval.json", "\"migrated\"") != 0) {
+        printf("[Error] JSON evaluation has keys of inactive options\n");
+        return 1;
+    }
+    // Latency over time in windows of 50 ms
+    logger_evaluate_windowed(evalListFull, evalListFullSize, 50000000, def, TAG_COUNT, NULL, NULL);
+    logger_evaluate_windowed(evalListFull, evalListFullSize, 50000000, def, TAG_COUNT, "test_window.csv",
+                             "test_window.json");
     logger_writeToCSV("test.csv", def, TAG_COUNT);
+    logger_writeToBinary("test.bin", def, TAG_COUNT);
     logger_reset();
     logger_evaluate(evalListFull, evalListFullSize, def, TAG_COUNT, NULL, NULL);
     logger_clear();
+
+    double value = 0.0;
+    if (csvValue("test_eval.csv", "TAG_DEMO_START-TAG_DEMO_END", "SAMPLING", &value) == 0) {
+        printf("[Error] Sampling columns without sampling\n");
+        return 1;
+    }
+
+    // Windowed evaluation. The END entries of every second span are in the other list.
+    conf.listCount = 2;
+    logger_init(conf);
+    for (int i = 0; i < 100; i++) {
+        if (i >= 30 && i < 60) {
+            continue;
+        }
+        struct timespec wt = {100, i * 1000000L};
+        logger_addLogEntryCustTime(TAG_DEMO_START, i, 0, wt);
+        wt.tv_nsec += 200000;
+        logger_addLogEntryCustTime(TAG_DEMO_END, i, i % 2, wt);
+    }
+    logger_tagPair_t windowPair = {TAG_DEMO_START, TAG_DEMO_END};
+    logger_evaluate_windowed(&windowPair, 1, 10000000, def, TAG_COUNT, "test_window.csv", NULL);
+    logger_clear();
+    if (checkWindows("test_window.csv") != 0) {
+        printf("[Error] Windows of the windowed evaluation do not match\n");
+        return 1;
+    }
+
+    // Sampling of one in ten spans, spread over two lists
+    logger_init(conf);
+    logger_tagPair_t demo2 = {TAG_DEMO2_START, TAG_DEMO2_END};
+    logger_setSampling(demo2, LSAMPLE_ONE_IN_N, 10);
+    for (int i = 0; i < 10000; i++) {
+        logger_addLogEntry(TAG_DEMO2_START, i, i % 2);
+        logger_addLogEntry(TAG_DEMO2_END, i, i % 2);
+    }
+    logger_evaluate(evalListFull, evalListFullSize, def, TAG_COUNT, NULL, NULL);
+    logger_evaluate(evalListFull, evalListFullSize, def, TAG_COUNT, "test_sampling.csv", "test_sampling.json");
+    double estCount = 0.0;
+    double sampling = 0.0;
+    if (csvValue("test_sampling.csv", "TAG_DEMO2_START-TAG_DEMO2_END", "EST_COUNT", &estCount) != 0 ||
+        csvValue("test_sampling.csv", "TAG_DEMO2_START-TAG_DEMO2_END", "SAMPLING", &sampling) != 0 ||
+        estCount != 10000.0 || sampling < 9.0 || sampling > 11.0 ||
+        fileContains("test_sampling.json", "\"est_count\":10000,") != 1 ||
+        fileContains("test_sampling.json", "\"cpus\"") != 0) {
+        printf("[Error] Sampling factor %f or estimated count %f does not match 1 in 10\n", sampling, estCount);
+        return 1;
+    }
+    logger_clear();
+    conf.listCount = 1;
+
+    // Periodic sampling with nested spans. The inner span is skipped as a whole while the outer one is open.
+    logger_init(conf);
+    logger_setSampling(demo2, LSAMPLE_PERIOD, 1);
+    struct timespec pt = {1, 0};
+    for (int i = 0; i < 100; i++) {
+        pt.tv_nsec = i * 1000;
+        logger_addLogEntryCustTime(TAG_DEMO2_START, 2 * i, 0, pt);
+        logger_addLogEntryCustTime(TAG_DEMO2_START, 2 * i + 1, 0, pt);
+        logger_addLogEntryCustTime(TAG_DEMO2_END, 2 * i + 1, 0, pt);
+        logger_addLogEntryCustTime(TAG_DEMO2_END, 2 * i, 0, pt);
+    }
+    logger_evaluate(evalListFull, evalListFullSize, def, TAG_COUNT, "test_sampling.csv", NULL);
+    if (logger_getEntryCount(0) != 200 ||
+        csvValue("test_sampling.csv", "TAG_DEMO2_START-TAG_DEMO2_END", "SAMPLING", &sampling) != 0 ||
+        sampling != 2.0) {
+        printf("[Error] Periodic sampling kept %d entries with factor %f\n", logger_getEntryCount(0), sampling);
+        return 1;
+    }
+    logger_clear();
+
+    // Outlier recording on a ring list that is much smaller than the capture
+    conf.listMode = LLIST_RING;
+    conf.listSize = 1000;
+    logger_init(conf);
+    logger_tagPair_t demo = {TAG_DEMO_START, TAG_DEMO_END};
+    logger_addOutlierRecorder(demo, 3, 5000, 16);
+    recordOutliers(100000);
+    logger_writeOutlierReport(NULL, def, TAG_COUNT);
+    logger_writeOutlierReport("test_outliers.csv", def, TAG_COUNT);
+    if (checkOutliers("test_outliers.csv", 3, 0.05, 100000) != 0) {
+        printf("[Error] Outlier report of the ring list does not match\n");
+        return 1;
+    }
+    logger_clear();
+
+    // Outlier recording on a compressed list. The window holds more entries than the context, so only the entries
+    // nearest to both ends of the window are kept.
+    conf.listMode = LLIST_COMPRESSED;
+    conf.listSize = 2048;
+    logger_init(conf);
+    logger_addOutlierRecorder(demo, 2, 50000, 16);
+    recordOutliers(20000);
+    logger_writeOutlierReport("test_outliers.csv", def, TAG_COUNT);
+    if (checkOutliers("test_outliers.csv", 2, 0.05, 20000) != 0) {
+        printf("[Error] Outlier report of the compressed list does not match\n");
+        return 1;
+    }
+    logger_clear();
+    // The compressed list keeps the same context entries as a plain list
+    conf.listMode = LLIST_PLAIN;
+    conf.listSize = 40000;
+    logger_init(conf);
+    logger_addOutlierRecorder(demo, 2, 50000, 16);
+    recordOutliers(20000);
+    logger_writeOutlierReport("test_outliers_plain.csv", def, TAG_COUNT);
+    logger_clear();
+    char *compressedReport = NULL;
+    char *plainReport = NULL;
+    if (readFile("test_outliers.csv", &compressedReport) < 0 || readFile("test_outliers_plain.csv", &plainReport) < 0 ||
+        strcmp(compressedReport, plainReport) != 0) {
+        printf("[Error] Outlier context of the compressed list differs from the plain list\n");
+        return 1;
+    }
+    free(compressedReport);
+    free(plainReport);
+
+    // 64 spans that are open at the same time are all matched
+    conf.listMode = LLIST_PLAIN;
+    conf.listSize = 1000;
+    logger_init(conf);
+    logger_addOutlierRecorder(demo, 1, 0, 0);
+    struct timespec open = {1, 0};
+    for (int i = 0; i < 64; i++) {
+        logger_addLogEntryCustTime(TAG_DEMO_START, i * 977, 0, open);
+    }
+    for (int i = 63; i >= 0; i--) {
+        open.tv_nsec += 1000;
+        logger_addLogEntryCustTime(TAG_DEMO_END, i * 977, 0, open);
+    }
+    logger_writeOutlierReport("test_outliers.csv", def, TAG_COUNT);
+    double spans = 0.0;
+    if (csvValue("test_outliers.csv", "1", "SPANS", &spans) != 0 || spans != 64.0) {
+        printf("[Error] Outlier recorder matched %f of 64 open spans\n", spans);
+        return 1;
+    }
+    logger_clear();
+
+    // Further open spans are dropped and counted in the report
+    logger_init(conf);
+    logger_addOutlierRecorder(demo, 1, 0, 0);
+    for (int i = 0; i < 70; i++) {
+        logger_addLogEntryCustTime(TAG_DEMO_START, i, 0, open);
+    }
+    logger_writeOutlierReport("test_outliers.csv", def, TAG_COUNT);
+    if (fileContains("test_outliers.csv", "\nDROPPED;TAG_DEMO_START-TAG_DEMO_END;6;64\n") != 1) {
+        printf("[Error] Dropped START entries are not reported\n");
+        return 1;
+    }
+    logger_clear();
+
+    // Same capture in the compressed list mode
+    conf.listMode = LLIST_COMPRESSED;
+    conf.listSize = 64;
+    logger_init(conf);
+    for (int i = 0; i < 1000; i++) {
+        logger_addLogEntry(TAG_DEMO_START, i, 0);
+        logger_addLogEntry(TAG_DEMO_END, i, 0);
+    }
+    if (logger_getEntryCount(0) != 2000) {
+        printf("[Error] Compressed list lost entries\n");
+        return 1;
+    }
+    printf("Compressed list: %ld bytes for %d entries\n", logger_getListMemUsage(0), logger_getEntryCount(0));
+    logger_evaluate(evalListFull, evalListFullSize, NULL, 0, NULL, NULL);
+    logger_writeToCSV("test_compressed.csv", NULL, 0);
+    logger_clear();
+
+    // The compressed list must decode to the same entries as a plain list
+    conf.listMode = LLIST_PLAIN;
+    conf.listSize = 3000;
+    logger_init(conf);
+    recordRoundTrip(3000);
+    logger_writeToBinary("test_plain_rt.bin", NULL, 0);
+    logger_clear();
+    conf.listMode = LLIST_COMPRESSED;
+    conf.listSize = 1024;
+    logger_init(conf);
+    recordRoundTrip(3000);
+    int compressedCount = logger_getEntryCount(0);
+    logger_writeToBinary("test_compressed_rt.bin", NULL, 0);
+    logger_clear();
+    char *plainData = NULL;
+    char *compressedData = NULL;
+    long plainSize = readFile("test_plain_rt.bin", &plainData);
+    long compressedSize = readFile("test_compressed_rt.bin", &compressedData);
+    if (compressedCount != 3000 || plainSize <= 0 || plainSize != compressedSize ||
+        memcmp(plainData, compressedData, plainSize) != 0) {
+        printf("[Error] Compressed list does not round-trip\n");
+        return 1;
+    }
+    free(plainData);
+    free(compressedData);
+    conf.listSize = 64;
+
+    // Tags registered at runtime get new tags after the GENERATE_DEF tags
+    logger_init(conf);
+    logger_tagPair_t plugin = {logger_registerTag("PLUGIN_START"), logger_registerTag("PLUGIN_END")};
+    if (plugin.tag_start != TAG_COUNT || logger_registerTag("PLUGIN_START") != plugin.tag_start ||
+        logger_findTag("TAG_DEMO_END") != TAG_DEMO_END ||
+        strcmp(logger_getTagName(plugin.tag_end), "PLUGIN_END") != 0) {
+        printf("[Error] Tag registry is inconsistent\n");
+        return 1;
+    }
+    for (int i = 0; i < 100; i++) {
+        logger_addLogEntry(plugin.tag_start, i, 0);
+        logger_addLogEntry(plugin.tag_end, i, 0);
+    }
+    logger_evaluate(&plugin, 1, NULL, 0, NULL, NULL);
+    logger_clear();
+
+    // Fixed tags must be in range and a fixed tag cannot be registered with another name
+    if (logger_registerTagWithId(LOGGER_TAG_MAX + 1, "TAG_TOO_LARGE") != -1 ||
+        logger_registerTagWithId(0x7fffffff, "TAG_TOO_LARGE") != -1 || logger_registerTagWithId(-1, "TAG_NEG") != -1 ||
+        logger_registerTagWithId(demoPair.tag_start, "TAG_OTHER") != -1 || logger_findTag("TAG_TOO_LARGE") != -1) {
+        printf("[Error] Invalid fixed tags are registered\n");
+        return 1;
+    }
+
+    // A plugin in another compilation unit gets tags after the GENERATE_DEF tags
+    int otherCount;
+    logger_tagDef_t *other = testTags_makeDef(&otherCount);
+    logger_tagPair_t otherPair = testTags_pair();
+    for (int i = 0; i < otherCount; i++) {
+        for (int j = 0; j < TAG_COUNT; j++) {
+            if (other[i].tag == def[j].tag) {
+                printf("[Error] Tag %s collides with %s\n", other[i].info, def[j].info);
+                return 1;
+            }
+        }
+        if (other[i].tag < TAG_COUNT || other[i].tag == plugin.tag_start || other[i].tag == plugin.tag_end ||
+            strcmp(logger_getTagName(other[i].tag), other[i].info) != 0) {
+            printf("[Error] Tag %s is not registered\n", other[i].info);
+            return 1;
+        }
+    }
+    if (otherPair.tag_start != other[0].tag || otherPair.tag_end != other[1].tag) {
+        printf("[Error] Tag variables of the plugin are not set\n");
+        return 1;
+    }
+    free(other);
+
+    // CPU of every entry. On Linux every second span is moved to another CPU between START and END. The spans are only
+    // checked for the moves, when the affinity could be set.
+    conf.recordCpu = 1;
+    logger_init(conf);
+    int cpuKnown = 0;
+    int pinned = 0;
+#if defined(__linux__) || defined(WIN)
+    cpuKnown = 1;
+#endif
+#ifdef __linux__
+    cpu_set_t oldSet;
+    int restore = sched_getaffinity(0, sizeof(oldSet), &oldSet) == 0;
+    pinned = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+#endif
+    for (int i = 0; i < 100; i++) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(0, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            pinned = 0;
+        }
+#endif
+        logger_addLogEntry(TAG_DEMO_START, i, 0);
+#ifdef __linux__
+        if (i % 2 == 1 && pinned) {
+            CPU_ZERO(&set);
+            CPU_SET(1, &set);
+            if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+                pinned = 0;
+            }
+        }
+#endif
+        logger_addLogEntry(TAG_DEMO_END, i, 0);
+    }
+#ifdef __linux__
+    if (restore) {
+        sched_setaffinity(0, sizeof(oldSet), &oldSet);
+    }
+#endif
+    logger_evaluate(evalListFull, evalListFullSize, def, TAG_COUNT, NULL, NULL);
+    logger_evaluate(evalListFull, evalListFullSize, def, TAG_COUNT, "test_cpu.csv", "test_cpu.json");
+    logger_evaluate_diff(evalListFull, evalListFullSize, def, TAG_COUNT, "test_cpu_diff.csv");
+    logger_writeToCSV("test_cpu_export.csv", def, TAG_COUNT);
+    logger_writeToBinary("test_cpu.bin", def, TAG_COUNT);
+    logger_clear();
+    if (checkCpus(cpuKnown, pinned) != 0 || fileContains("test_cpu.json", "\"migrated\"") != 1) {
+        printf("[Error] CPUs of the spans do not match the reports\n");
+        return 1;
+    }
+    conf.recordCpu = 0;
+    free(def);
+    logger_freeTags();
+    if (logger_findTag("TAG_DEMO_START") != -1 || logger_registerTag("TAG_DEMO_END") != 0) {
+        printf("[Error] Tag registry is not freed\n");
+        return 1;
+    }
+    logger_freeTags();
     return 0;
 }
\ No newline at end of file
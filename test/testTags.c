@@ -0,0 +1,41 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: A second compilation unit, e.g. a plugin. It registers its tags at runtime, so they do not collide with
+ *               the GENERATE_DEF tags of test.c.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+
+static const char *PLUGIN_TAGS[] = {"TAG_PLUGIN_START", "TAG_PLUGIN_END", "TAG_PLUGIN2_START", "TAG_PLUGIN2_END"};
+static logger_logTag_t TAG_PLUGIN_START = -1;
+static logger_logTag_t TAG_PLUGIN_END = -1;
+
+logger_tagDef_t *testTags_makeDef(int *count) {
+    *count = sizeof(PLUGIN_TAGS) / sizeof(PLUGIN_TAGS[0]);
+    logger_tagDef_t *def = (logger_tagDef_t *)malloc(sizeof(logger_tagDef_t) * *count);
+    for (int i = 0; i < *count; i++) {
+        def[i].tag = logger_registerTag(PLUGIN_TAGS[i]);
+        strcpy(def[i].info, PLUGIN_TAGS[i]);
+    }
+    TAG_PLUGIN_START = def[0].tag;
+    TAG_PLUGIN_END = def[1].tag;
+    return def;
+}
+
+logger_tagPair_t testTags_pair(void) {
+    logger_tagPair_t pair = {TAG_PLUGIN_START, TAG_PLUGIN_END};
+    return pair;
+}
@@ -0,0 +1,562 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains the tests of the rtperflog tools. The paths of the tools are passed as arguments.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture.h"
+#include "logger.h"
+#include "loggerFormat.h"
+#include "loggerUtil.h"
+#include "stats.h"
+#ifndef WIN
+#include <sys/wait.h>
+#endif
+
+// Runs a tool and returns its exit code
+static int runTool(const char *tool, const char *args) {
+    char command[1024];
+    snprintf(command, sizeof(command), "\"%s\" %s", tool, args);
+    int status = system(command);
+#ifndef WIN
+    if (status != -1 && WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    return -1;
+#else
+    return status;
+#endif
+}
+
+// Writes a binary capture with spans of the tag pair SPAN. The durations are base plus a spread of 0-99us, offset is
+// added to every timestamp.
+static void writeSpans(const char *fileName, int count, long base, int64_t offset) {
+    logger_config_t conf = {0};
+    conf.listCount = 1;
+    conf.listSize = 2 * count;
+    logger_init(conf);
+    logger_logTag_t start = logger_registerTag("SPAN_START");
+    logger_logTag_t end = logger_registerTag("SPAN_END");
+    int64_t ns = 1000000000LL + offset;
+    for (int i = 0; i < count; i++) {
+        struct timespec t = {(time_t)(ns / 1000000000LL), (long)(ns % 1000000000LL)};
+        logger_addLogEntryCustTime(start, i, 0, t);
+        int64_t endNs = ns + base + (i * 7919L % 100) * 1000L;
+        struct timespec te = {(time_t)(endNs / 1000000000LL), (long)(endNs % 1000000000LL)};
+        logger_addLogEntryCustTime(end, i, 0, te);
+        ns += 1000000;
+    }
+    logger_writeToBinary(fileName, NULL, 0);
+    logger_clear();
+}
+
+// Deterministic samples with a long tail, sorted
+static double *makeSamples(long n, double shift) {
+    double *samples = (double *)malloc(sizeof(double) * n);
+    unsigned long state = 12345;
+    for (long i = 0; i < n; i++) {
+        state = state * 6364136223846793005ul + 1442695040888963407ul;
+        double u = ((double)(state >> 11) + 0.5) / 9007199254740992.0;
+        samples[i] = 0.1 - 0.02 * log(u) + shift;
+    }
+    qsort(samples, n, sizeof(double), _logger_compareDouble);
+    return samples;
+}
+
+static int testStats() {
+    double values[101];
+    for (int i = 0; i < 101; i++) {
+        values[i] = i + 1;
+    }
+    if (stats_quantile(values, 101, 0.5) != 51.0 || stats_quantile(values, 101, 0.99) != 100.0 ||
+        fabs(stats_quantile(values, 100, 0.5) - 50.5) > 1e-12) {
+        printf("[Error] stats_quantile\n");
+        return 1;
+    }
+    // U = 0 for completely separated samples: z = -12.5 / sqrt(25 * 11 / 12)
+    double a[] = {1, 2, 3, 4, 5};
+    double b[] = {6, 7, 8, 9, 10};
+    double p = stats_mannWhitney(a, 5, b, 5);
+    if (fabs(p - erfc(12.5 / sqrt(25.0 * 11.0 / 12.0) / sqrt(2.0))) > 1e-12 || stats_mannWhitney(a, 5, a, 5) != 1.0) {
+        printf("[Error] stats_mannWhitney %g\n", p);
+        return 1;
+    }
+    double *base = makeSamples(2000, 0.0);
+    double *same = makeSamples(2000, 0.0);
+    double *slower = makeSamples(2000, 0.05);
+    double low, high;
+    stats_quantileDeltaCI(base, 2000, same, 2000, 0.99, 0.99, &low, &high);
+    if (low > 0.0 || high < 0.0) {
+        printf("[Error] p99 delta CI [%f,%f] of identical samples excludes 0\n", low, high);
+        return 1;
+    }
+    stats_quantileDeltaCI(base, 2000, slower, 2000, 0.5, 0.99, &low, &high);
+    if (low <= 0.0 || low > 0.05 || high < 0.05) {
+        printf("[Error] Median delta CI [%f,%f] does not cover the shift of 0.05\n", low, high);
+        return 1;
+    }
+    double low95, high95;
+    stats_quantileDeltaCI(base, 2000, slower, 2000, 0.5, 0.95, &low95, &high95);
+    if (low95 < low || high95 > high) {
+        printf("[Error] 95%% CI [%f,%f] is wider than the 99%% CI [%f,%f]\n", low95, high95, low, high);
+        return 1;
+    }
+    free(base);
+    free(same);
+    free(slower);
+    return 0;
+}
+
+// The CSV export and the binary capture of the same lists must read back the same entries
+static int testCapture() {
+    writeSpans("tools_spans.bin", 100, 100000, 0);
+    logger_config_t conf = {0};
+    conf.listCount = 1;
+    conf.listSize = 200;
+    logger_init(conf);
+    logger_logTag_t start = logger_registerTag("SPAN_START");
+    logger_logTag_t end = logger_registerTag("SPAN_END");
+    int64_t ns = 1000000000LL;
+    for (int i = 0; i < 100; i++) {
+        struct timespec t = {(time_t)(ns / 1000000000LL), (long)(ns % 1000000000LL)};
+        logger_addLogEntryCustTime(start, i, 0, t);
+        int64_t endNs = ns + 100000 + (i * 7919L % 100) * 1000L;
+        struct timespec te = {(time_t)(endNs / 1000000000LL), (long)(endNs % 1000000000LL)};
+        logger_addLogEntryCustTime(end, i, 0, te);
+        ns += 1000000;
+    }
+    logger_writeToCSV("tools_spans.csv", NULL, 0);
+    logger_clear();
+    capture_t bin, csv;
+    if (capture_open(&bin, "tools_spans.bin") != 0 || capture_open(&csv, "tools_spans.csv") != 0) {
+        printf("[Error] Could not open the captures\n");
+        return 1;
+    }
+    capture_entry_t eb, ec;
+    int count = 0;
+    int ret = 0;
+    while (capture_next(&bin, &eb) == 1) {
+        if (capture_next(&csv, &ec) != 1 || eb.id != ec.id || eb.time != ec.time || eb.list != 0 || ec.list != 0 ||
+            strcmp(capture_tagName(&bin, eb.tag), capture_tagName(&csv, ec.tag)) != 0) {
+            ret = 1;
+            break;
+        }
+        count++;
+    }
+    if (ret != 0 || count != 200 || capture_next(&csv, &ec) != 0) {
+        printf("[Error] CSV and binary capture differ after %d entries\n", count);
+        ret = 1;
+    }
+    capture_close(&bin);
+    capture_close(&csv);
+    if (ret != 0) {
+        return ret;
+    }
+
+    // Optional CPU and list columns and the time base of the metadata line
+    FILE *pFile = fopen("tools_columns.csv", "w");
+    fprintf(pFile, "#rtperflog;version=1;clock=1;base_sec=5;pid=42\n\nA_START,1,0.000000100\nA_END,1,1.5,3\n"
+                   "A_START,2,-1.250000000,,7\n");
+    fclose(pFile);
+    capture_entry_t entries[3];
+    if (capture_open(&csv, "tools_columns.csv") != 0) {
+        return 1;
+    }
+    int64_t pos = 0;
+    for (count = 0; count < 3 && capture_next(&csv, &entries[count]) == 1; count++) {
+        if (count == 1) {
+            pos = capture_tell(&csv);
+        }
+    }
+    capture_entry_t again;
+    if (count != 3 || csv.pid != 42 || csv.clockType != 1 || capture_next(&csv, &again) != 0 ||
+        entries[0].time != 5000000100LL || entries[0].cpu != -1 || entries[0].list != 0 ||
+        entries[1].time != 6500000000LL || entries[1].cpu != 3 || entries[1].list != 0 ||
+        entries[2].time != 4250000000LL || entries[2].cpu != -1 || entries[2].list != 7 ||
+        strcmp(capture_tagName(&csv, entries[1].tag), "A_END") != 0 || capture_seek(&csv, pos) != 0 ||
+        capture_next(&csv, &again) != 1 || again.id != 2 || again.time != entries[2].time) {
+        printf("[Error] CSV columns are not read back\n");
+        ret = 1;
+    }
+    capture_close(&csv);
+    if (ret != 0) {
+        return ret;
+    }
+
+    // Binary captures of version 1 have no CPU
+    _logger_fileHeader_t header = {{'R', 'T', 'P', 'L'}, 1, 1, 1, 2};
+    _logger_fileTag_t tag = {3, "A_START"};
+    _logger_fileEntryV1_t v1[2] = {{3, 5, 1, 1000}, {3, 6, 2, 2000}};
+    pFile = fopen("tools_v1.bin", "wb");
+    fwrite(&header, sizeof(header), 1, pFile);
+    fwrite(&tag, sizeof(tag), 1, pFile);
+    fwrite(v1, sizeof(v1), 1, pFile);
+    fclose(pFile);
+    if (capture_open(&bin, "tools_v1.bin") != 0) {
+        return 1;
+    }
+    if (capture_next(&bin, &eb) != 1 || capture_next(&bin, &ec) != 1 || capture_next(&bin, &again) != 0 ||
+        eb.list != 5 || eb.cpu != -1 || eb.id != 1 || eb.time != 1000 || ec.list != 6 || ec.time != 2000 ||
+        strcmp(capture_tagName(&bin, eb.tag), "A_START") != 0) {
+        printf("[Error] Binary capture of version 1 is not read back\n");
+        ret = 1;
+    }
+    capture_close(&bin);
+    return ret;
+}
+
+static int testCompare(const char *compare) {
+    writeSpans("tools_base.bin", 2000, 100000, 0);
+    writeSpans("tools_same.bin", 2000, 100000, 0);
+    writeSpans("tools_slow.bin", 2000, 130000, 0);
+    int same = runTool(compare, "tools_base.bin tools_same.bin");
+    int slow = runTool(compare, "-o tools_compare.csv tools_base.bin tools_slow.bin");
+    if (same != 0 || slow != 1) {
+        printf("[Error] rtperflog-compare returned %d for identical and %d for slower spans\n", same, slow);
+        return 1;
+    }
+
+    // Spans that start in list 0 and end in list 1 are compared. The pair NEW only has spans in the candidate.
+    for (int run = 0; run < 2; run++) {
+        logger_config_t conf = {0};
+        conf.listCount = 2;
+        conf.listSize = 200;
+        logger_init(conf);
+        logger_logTag_t tags[4] = {logger_registerTag("SPAN_START"), logger_registerTag("SPAN_END"),
+                                   logger_registerTag("NEW_START"), logger_registerTag("NEW_END")};
+        for (int i = 0; i < 50; i++) {
+            for (int p = 0; p < 1 + run; p++) {
+                struct timespec ts = {1 + p, i * 1000000L};
+                struct timespec te = {1 + p, i * 1000000L + 100000L + (i % 10) * 1000L};
+                logger_addLogEntryCustTime(tags[2 * p], i, 0, ts);
+                logger_addLogEntryCustTime(tags[2 * p + 1], i, 1, te);
+            }
+        }
+        logger_writeToBinary(run ? "tools_cand_lists.bin" : "tools_base_lists.bin", NULL, 0);
+        logger_clear();
+    }
+    if (runTool(compare, "-o tools_compare.csv tools_base_lists.bin tools_cand_lists.bin") != 0) {
+        printf("[Error] rtperflog-compare of spans across lists\n");
+        return 1;
+    }
+    FILE *pFile = fopen("tools_compare.csv", "r");
+    char line[1024];
+    int rows = 0;
+    while (fgets(line, sizeof(line), pFile) != NULL) {
+        long countA;
+        long countB;
+        rows += sscanf(line, "SPAN;%ld;%ld;", &countA, &countB) == 2 && countA == 50 && countB == 50 &&
+                strstr(line, ";OK\n") != NULL;
+        rows += sscanf(line, "NEW;%ld;%ld;", &countA, &countB) == 2 && countA == 0 && countB == 50 &&
+                strstr(line, ";;NEW\n") != NULL;
+    }
+    fclose(pFile);
+    if (rows != 2) {
+        printf("[Error] rtperflog-compare did not report the spans across lists and the new pair\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Reads a merged capture and checks that the timestamps do not decrease. Returns the count of entries or -1.
+static int readMerged(const char *fileName, capture_entry_t *entries, int size) {
+    capture_t cap;
+    if (capture_open(&cap, fileName) != 0) {
+        return -1;
+    }
+    capture_entry_t entry;
+    int count = 0;
+    int64_t last = INT64_MIN;
+    while (capture_next(&cap, &entry) == 1) {
+        if (entry.time < last) {
+            printf("[Error] %s is not ordered at entry %d\n", fileName, count);
+            count = -1;
+            break;
+        }
+        last = entry.time;
+        if (count < size) {
+            entries[count] = entry;
+        }
+        count++;
+    }
+    capture_close(&cap);
+    return count;
+}
+
+static int testMerge(const char *merge) {
+    // Entries of both inputs are interleaved by time. Their ids overlap, their lists do not.
+    writeSpans("tools_merge_a.bin", 100, 100000, 0);
+    writeSpans("tools_merge_b.bin", 100, 100000, 500000);
+    capture_entry_t entries[400];
+    for (int binary = 0; binary < 2; binary++) {
+        const char *out = binary ? "tools_merged.bin" : "tools_merged.csv";
+        char args[256];
+        snprintf(args, sizeof(args), "%s-o %s tools_merge_a.bin tools_merge_b.bin", binary ? "-b " : "", out);
+        if (runTool(merge, args) != 0 || readMerged(out, entries, 400) != 400) {
+            printf("[Error] rtperflog-merge of two captures into %s\n", out);
+            return 1;
+        }
+        int lists[2] = {0, 0};
+        for (int i = 0; i < 400; i++) {
+            int fromB = (entries[i].time - 1000000000LL) % 1000000 >= 500000;
+            if (entries[i].list != fromB) {
+                printf("[Error] Entry %d of %s has list %d\n", i, out, entries[i].list);
+                return 1;
+            }
+            lists[entries[i].list]++;
+        }
+        if (entries[0].time != 1000000000LL || lists[0] != 200 || lists[1] != 200) {
+            printf("[Error] %s starts at %lld with %d and %d entries\n", out, (long long)entries[0].time, lists[0],
+                   lists[1]);
+            return 1;
+        }
+    }
+
+    // The rows of a CSV export are relative to base_sec of its metadata line
+    FILE *pFile = fopen("tools_merge_a.csv", "w");
+    fprintf(pFile, "#rtperflog;version=1;clock=1;base_sec=100\nSPAN_START,0,0.500000000\nSPAN_END,0,0.700000000\n");
+    fclose(pFile);
+    pFile = fopen("tools_merge_b.csv", "w");
+    fprintf(pFile, "#rtperflog;version=1;clock=1;base_sec=99\nSPAN_START,1,1.600000000\nSPAN_END,1,1.650000000\n");
+    fclose(pFile);
+    int64_t times[4] = {100500000000LL, 100600000000LL, 100650000000LL, 100700000000LL};
+    int expectedLists[4] = {0, 1, 1, 0};
+    if (runTool(merge, "-o tools_merged.csv tools_merge_a.csv tools_merge_b.csv") != 0 ||
+        readMerged("tools_merged.csv", entries, 4) != 4) {
+        printf("[Error] rtperflog-merge of two CSV exports\n");
+        return 1;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (entries[i].time != times[i] || entries[i].list != expectedLists[i]) {
+            printf("[Error] Merged entry %d at %lld in list %d\n", i, (long long)entries[i].time, entries[i].list);
+            return 1;
+        }
+    }
+
+    // Every entry of a descending capture is its own run, so the runs are merged in several passes
+    pFile = fopen("tools_merge_runs.csv", "w");
+    for (int i = 0; i < 1200; i++) {
+        fprintf(pFile, "SPAN_START,%d,0.%09d\n", i, (1200 - i) * 1000);
+    }
+    fclose(pFile);
+    if (runTool(merge, "-o tools_merged.csv tools_merge_runs.csv") != 0 ||
+        readMerged("tools_merged.csv", entries, 1) != 1200 || entries[0].id != 1199) {
+        printf("[Error] rtperflog-merge of 1200 runs\n");
+        return 1;
+    }
+    pFile = fopen("tools_merged.csv.1.tmp", "r");
+    if (pFile != NULL) {
+        fclose(pFile);
+        printf("[Error] rtperflog-merge left a temporary capture\n");
+        return 1;
+    }
+
+    // List numbers above 16 bits survive the binary capture and the merge, which offsets the lists of the second input
+    logger_config_t conf = {0};
+    conf.listCount = 40000;
+    conf.listSize = 2;
+    logger_init(conf);
+    logger_logTag_t start = logger_registerTag("SPAN_START");
+    struct timespec t = {1, 0};
+    logger_addLogEntryCustTime(start, 7, 39999, t);
+    logger_writeToBinary("tools_merge_lists.bin", NULL, 0);
+    logger_clear();
+    if (readMerged("tools_merge_lists.bin", entries, 1) != 1 || entries[0].list != 39999 || entries[0].id != 7) {
+        printf("[Error] Binary capture has list %d instead of 39999\n", entries[0].list);
+        return 1;
+    }
+    if (runTool(merge, "-b -o tools_merged.bin tools_merge_lists.bin tools_merge_lists.bin") != 0 ||
+        readMerged("tools_merged.bin", entries, 2) != 2 || entries[0].list + entries[1].list != 39999 + 79999) {
+        printf("[Error] rtperflog-merge of lists above 32767\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Runs rtperflog-analyze with -o and reads count, min and max of the pair SPAN. Returns 0 if the pair was evaluated.
+static int analyzeSpans(const char *analyze, const char *args, unsigned long *count, double *min, double *max) {
+    char command[512];
+    snprintf(command, sizeof(command), "-p SPAN -o tools_analyze.csv %s", args);
+    if (runTool(analyze, command) != 0) {
+        return -1;
+    }
+    FILE *pFile = fopen("tools_analyze.csv", "r");
+    if (pFile == NULL) {
+        return -1;
+    }
+    char line[512];
+    int ret = -1;
+    while (fgets(line, sizeof(line), pFile) != NULL) {
+        if (sscanf(line, "SPAN_START-SPAN_END;%lu;%lf;%lf", count, min, max) == 3) {
+            ret = 0;
+        }
+    }
+    fclose(pFile);
+    return ret;
+}
+
+static int testAnalyze(const char *analyze, const char *merge) {
+    // The durations of writeSpans are 100-199us
+    unsigned long count;
+    double min, max;
+    writeSpans("tools_analyze_a.bin", 100, 100000, 0);
+    if (analyzeSpans(analyze, "tools_analyze_a.bin", &count, &min, &max) != 0 || count != 100 ||
+        fabs(min - 0.1) > 1e-9 || fabs(max - 0.199) > 1e-9) {
+        printf("[Error] rtperflog-analyze evaluated %lu spans of %f-%fms\n", count, min, max);
+        return 1;
+    }
+
+    // -l selects the list of a merged capture, a CSV export without list column is list 0
+    writeSpans("tools_analyze_b.bin", 50, 100000, 500000);
+    if (runTool(merge, "-o tools_analyze_m.csv tools_analyze_a.bin tools_analyze_b.bin") != 0 ||
+        analyzeSpans(analyze, "-l 1 tools_analyze_m.csv", &count, &min, &max) != 0 || count != 50) {
+        printf("[Error] rtperflog-analyze -l 1 of a merged capture\n");
+        return 1;
+    }
+    FILE *pFile = fopen("tools_analyze_nolist.csv", "w");
+    fprintf(pFile, "SPAN_START,1,1.000000000\nSPAN_END,1,1.000200000\n");
+    fclose(pFile);
+    if (analyzeSpans(analyze, "-l 0 tools_analyze_nolist.csv", &count, &min, &max) != 0 || count != 1) {
+        printf("[Error] rtperflog-analyze -l 0 of a CSV export\n");
+        return 1;
+    }
+
+    // A span that starts in one process and ends in another one is matched by its id in the merged capture
+    pFile = fopen("tools_analyze_p1.csv", "w");
+    fprintf(pFile, "#rtperflog;version=1;clock=1;base_sec=10;pid=1\nSPAN_START,7,0.000100000\n");
+    fclose(pFile);
+    pFile = fopen("tools_analyze_p2.csv", "w");
+    fprintf(pFile, "#rtperflog;version=1;clock=1;base_sec=10;pid=2\nSPAN_END,7,0.000300000\n");
+    fclose(pFile);
+    for (int binary = 0; binary < 2; binary++) {
+        const char *out = binary ? "tools_analyze_p.bin" : "tools_analyze_p.csv";
+        char args[256];
+        snprintf(args, sizeof(args), "%s-o %s tools_analyze_p1.csv tools_analyze_p2.csv", binary ? "-b " : "", out);
+        if (runTool(merge, args) != 0 || analyzeSpans(analyze, out, &count, &min, &max) != 0 || count != 1 ||
+            fabs(min - 0.2) > 1e-9) {
+            printf("[Error] rtperflog-analyze of a span across the processes of %s\n", out);
+            return 1;
+        }
+    }
+
+    // Like logger_evaluate, a span may start in one list and end in another one. -l only filters the entries.
+    logger_config_t conf = {0};
+    conf.listCount = 2;
+    conf.listSize = 10;
+    logger_init(conf);
+    logger_logTag_t start = logger_registerTag("SPAN_START");
+    logger_logTag_t end = logger_registerTag("SPAN_END");
+    for (int i = 0; i < 5; i++) {
+        struct timespec ts = {1, i * 1000000L};
+        struct timespec te = {1, i * 1000000L + 300000L};
+        logger_addLogEntryCustTime(start, i, 0, ts);
+        logger_addLogEntryCustTime(end, i, 1, te);
+    }
+    logger_writeToBinary("tools_analyze_lists.bin", NULL, 0);
+    logger_clear();
+    if (analyzeSpans(analyze, "tools_analyze_lists.bin", &count, &min, &max) != 0 || count != 5 ||
+        fabs(min - 0.3) > 1e-9 || analyzeSpans(analyze, "-l 0 tools_analyze_lists.bin", &count, &min, &max) != 0 ||
+        count != 0) {
+        printf("[Error] rtperflog-analyze of spans across lists\n");
+        return 1;
+    }
+
+    // 20 START entries that never end, then spans with up to 5 open at the same time. With 10 open spans the oldest
+    // START entries are dropped, which are the ones without END.
+    pFile = fopen("tools_analyze_open.csv", "w");
+    for (int i = 0; i < 20; i++) {
+        fprintf(pFile, "SPAN_START,%d,1.%09d\n", 10000 + i, i);
+    }
+    for (int i = 0; i < 104; i++) {
+        if (i < 100) {
+            fprintf(pFile, "SPAN_START,%d,2.%09d\n", i, i * 1000);
+        }
+        if (i >= 4) {
+            fprintf(pFile, "SPAN_END,%d,2.%09d\n", i - 4, i * 1000 + 500);
+        }
+    }
+    fclose(pFile);
+    if (analyzeSpans(analyze, "-m 10 tools_analyze_open.csv", &count, &min, &max) != 0 || count != 100 ||
+        fabs(min - 0.0045) > 1e-9) {
+        printf("[Error] rtperflog-analyze -m 10 evaluated %lu spans\n", count);
+        return 1;
+    }
+
+    // Windows of 10ms over spans that start every 1ms
+    if (runTool(analyze, "-p SPAN -w 10 -o tools_analyze.csv tools_analyze_a.bin") != 0) {
+        printf("[Error] rtperflog-analyze -w failed\n");
+        return 1;
+    }
+    pFile = fopen("tools_analyze.csv", "r");
+    char line[512];
+    int windows = 0;
+    while (fgets(line, sizeof(line), pFile) != NULL) {
+        double start;
+        if (sscanf(line, "SPAN_START-SPAN_END;%lf;;%lu", &start, &count) == 2) {
+            if (count != 10 || fabs(start - (1.0 + 0.01 * windows)) > 1e-9) {
+                windows = -1;
+                break;
+            }
+            windows++;
+        }
+    }
+    fclose(pFile);
+    if (windows != 10) {
+        printf("[Error] rtperflog-analyze -w wrote %d windows\n", windows);
+        return 1;
+    }
+
+    // Only windows with spans take memory, so spans that are 11 days apart in windows of 1ms are two windows
+    pFile = fopen("tools_analyze_gap.csv", "w");
+    fprintf(pFile, "SPAN_START,1,1.000000000\nSPAN_END,1,1.000100000\n");
+    fprintf(pFile, "SPAN_START,2,1000000.000000000\nSPAN_END,2,1000000.000200000\n");
+    fclose(pFile);
+    if (runTool(analyze, "-p SPAN -w 1 -o tools_analyze.csv tools_analyze_gap.csv") != 0) {
+        printf("[Error] rtperflog-analyze -w of distant spans failed\n");
+        return 1;
+    }
+    pFile = fopen("tools_analyze.csv", "r");
+    double starts[2] = {0.0, 0.0};
+    windows = 0;
+    while (fgets(line, sizeof(line), pFile) != NULL) {
+        double start;
+        if (sscanf(line, "SPAN_START-SPAN_END;%lf;;%lu", &start, &count) == 2 && windows < 2) {
+            starts[windows++] = start;
+        }
+    }
+    fclose(pFile);
+    if (windows != 2 || starts[0] != 1.0 || starts[1] != 1000000.0) {
+        printf("[Error] rtperflog-analyze -w wrote %d windows of distant spans\n", windows);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        printf("Usage: rtperflogToolsTest <rtperflog-compare> <rtperflog-merge> <rtperflog-analyze>\n");
+        return 1;
+    }
+    if (testStats() != 0 || testCapture() != 0 || testCompare(argv[1]) != 0 || testMerge(argv[2]) != 0 ||
+        testAnalyze(argv[3], argv[2]) != 0) {
+        return 1;
+    }
+    logger_freeTags();
+    printf("Tools tests passed\n");
+    return 0;
+}
@@ -0,0 +1,523 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains rtperflog-analyze, which evaluates captures in a single streaming pass.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture.h"
+#include "loggerFormat.h"
+#include "loggerHist.h"
+
+// Default limit of open spans per tag pair. Above it, the oldest START entries without an END are dropped.
+#define ANALYZE_MAX_OPEN (1 << 20)
+
+// A START entry in the order the spans were opened
+typedef struct {
+    unsigned long id;
+    int64_t time;
+} analyze_open_t;
+
+typedef struct {
+    char name[CAPTURE_NAME_MAX];
+    char startName[CAPTURE_NAME_MAX];
+    char endName[CAPTURE_NAME_MAX];
+    capture_idMap_t open;
+    // START entries of open in the order they were opened, orderHead..orderEnd-1. Entries that were matched or
+    // replaced in the meantime are skipped.
+    analyze_open_t *order;
+    long orderHead;
+    long orderEnd;
+    long orderSize;
+    _logger_hist_t hist;
+    int64_t first;
+    int64_t last;
+    long dropped;
+    // Windowed mode: histograms of the windows with spans, like logger_evaluate_windowed
+    _logger_windowMap_t windows;
+} analyze_pair_t;
+
+typedef struct {
+    analyze_pair_t *pairs;
+    int count;
+    // 1 when the pairs are given by -p, otherwise every <PAIR>_START/<PAIR>_END pair is evaluated
+    int fixed;
+    long maxOpen;
+    int64_t windowNs;
+    int *lists;
+    int listCount;
+    char **tags;
+    int tagCount;
+    FILE *diffFile;
+    FILE *exportFile;
+    int64_t exportBase;
+    int exportStarted;
+    int clockType;
+} analyze_t;
+
+/**
+ * Roles of a tag of a capture. A tag can be the START or END of several pairs.
+ * Each role is pair * 2 + isStart.
+ */
+typedef struct {
+    int resolved;
+    int pass;
+    int *roles;
+    int roleCount;
+} analyze_tag_t;
+
+static int addPair(analyze_t *an, const char *name, const char *startName, const char *endName) {
+    an->pairs = (analyze_pair_t *)realloc(an->pairs, sizeof(analyze_pair_t) * (an->count + 1));
+    analyze_pair_t *pair = &an->pairs[an->count];
+    memset(pair, 0, sizeof(analyze_pair_t));
+    snprintf(pair->name, sizeof(pair->name), "%s", name);
+    snprintf(pair->startName, sizeof(pair->startName), "%s", startName);
+    snprintf(pair->endName, sizeof(pair->endName), "%s", endName);
+    capture_idMapInit(&pair->open);
+    _logger_histInit(&pair->hist);
+    return an->count++;
+}
+
+// Parses -p <PAIR> or -p <START_TAG>:<END_TAG>
+static void parsePair(analyze_t *an, const char *arg) {
+    char start[CAPTURE_NAME_MAX];
+    char end[CAPTURE_NAME_MAX];
+    char name[CAPTURE_NAME_MAX];
+    const char *colon = strchr(arg, ':');
+    if (colon != NULL) {
+        snprintf(start, sizeof(start), "%.*s", (int)(colon - arg), arg);
+        snprintf(end, sizeof(end), "%s", colon + 1);
+        snprintf(name, sizeof(name), "%s", arg);
+    } else {
+        snprintf(start, sizeof(start), "%s_START", arg);
+        snprintf(end, sizeof(end), "%s_END", arg);
+        snprintf(name, sizeof(name), "%s", arg);
+    }
+    an->fixed = 1;
+    addPair(an, name, start, end);
+}
+
+static void addRole(analyze_tag_t *tag, int role) {
+    tag->roles = (int *)realloc(tag->roles, sizeof(int) * (tag->roleCount + 1));
+    tag->roles[tag->roleCount++] = role;
+}
+
+static void resolveTag(analyze_t *an, analyze_tag_t *tag, const char *name) {
+    tag->resolved = 1;
+    tag->pass = an->tagCount == 0;
+    for (int t = 0; t < an->tagCount; t++) {
+        if (strcmp(an->tags[t], name) == 0) {
+            tag->pass = 1;
+        }
+    }
+    if (!tag->pass) {
+        return;
+    }
+    if (!an->fixed) {
+        char pairName[CAPTURE_NAME_MAX];
+        int isStart;
+        if (capture_splitTag(name, pairName, sizeof(pairName), &isStart) != 0) {
+            return;
+        }
+        for (int p = 0; p < an->count; p++) {
+            if (strcmp(an->pairs[p].name, pairName) == 0) {
+                addRole(tag, p * 2 + isStart);
+                return;
+            }
+        }
+        char start[CAPTURE_NAME_MAX + 8];
+        char end[CAPTURE_NAME_MAX + 8];
+        snprintf(start, sizeof(start), "%s_START", pairName);
+        snprintf(end, sizeof(end), "%s_END", pairName);
+        addRole(tag, addPair(an, pairName, start, end) * 2 + isStart);
+        return;
+    }
+    for (int p = 0; p < an->count; p++) {
+        if (strcmp(an->pairs[p].startName, name) == 0) addRole(tag, p * 2 + 1);
+        if (strcmp(an->pairs[p].endName, name) == 0) addRole(tag, p * 2);
+    }
+}
+
+static int listPasses(const analyze_t *an, int list) {
+    if (an->listCount == 0) {
+        return 1;
+    }
+    for (int l = 0; l < an->listCount; l++) {
+        if (an->lists[l] == list) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int isOpen(analyze_pair_t *pair, const analyze_open_t *start) {
+    int64_t time;
+    return capture_idMapGet(&pair->open, start->id, &time) && time == start->time;
+}
+
+// Drops the oldest open START entry of a pair
+static void dropOldest(analyze_pair_t *pair) {
+    while (pair->orderHead < pair->orderEnd) {
+        analyze_open_t *start = &pair->order[pair->orderHead++];
+        if (isOpen(pair, start)) {
+            int64_t time;
+            capture_idMapTake(&pair->open, start->id, &time);
+            pair->dropped++;
+            return;
+        }
+    }
+}
+
+static void openSpan(analyze_t *an, analyze_pair_t *pair, const capture_entry_t *entry) {
+    if (pair->open.count >= an->maxOpen) {
+        // Bound the memory: START entries that never end are dropped, the oldest first
+        dropOldest(pair);
+    }
+    capture_idMapPut(&pair->open, entry->id, entry->time);
+    if (pair->orderEnd == pair->orderSize) {
+        // Remove the matched entries and grow, when more than half of the entries are still open
+        long live = 0;
+        for (long i = pair->orderHead; i < pair->orderEnd; i++) {
+            if (isOpen(pair, &pair->order[i])) {
+                pair->order[live++] = pair->order[i];
+            }
+        }
+        pair->orderHead = 0;
+        pair->orderEnd = live;
+        if (live * 2 >= pair->orderSize) {
+            pair->orderSize = pair->orderSize == 0 ? 1024 : pair->orderSize * 2;
+            pair->order = (analyze_open_t *)realloc(pair->order, sizeof(analyze_open_t) * pair->orderSize);
+        }
+    }
+    analyze_open_t *start = &pair->order[pair->orderEnd++];
+    start->id = entry->id;
+    start->time = entry->time;
+}
+
+static void exportEntry(analyze_t *an, const char *name, const capture_entry_t *entry) {
+    if (!an->exportStarted) {
+        // The first entry sets the time base of the export
+        an->exportBase = entry->time / 1000000000LL - (entry->time < 0 ? 1 : 0);
+        fprintf(an->exportFile, "#rtperflog;version=%d;clock=%d;base_sec=%lld\n", LOGGER_CSV_VERSION, an->clockType,
+                (long long)an->exportBase);
+        an->exportStarted = 1;
+    }
+    char time[32];
+    capture_formatTime(time, sizeof(time), entry->time - an->exportBase * 1000000000LL);
+    fprintf(an->exportFile, "%s,%lu,%s", name, entry->id, time);
+    if (entry->cpu >= 0) {
+        fprintf(an->exportFile, ",%d", entry->cpu);
+    }
+    fprintf(an->exportFile, "\n");
+}
+
+static int64_t floorDiv(int64_t a, int64_t b) { return a / b - ((a % b != 0) && ((a < 0) != (b < 0))); }
+
+static void addSpan(analyze_t *an, analyze_pair_t *pair, int64_t start, int64_t end) {
+    _logger_histAdd(&pair->hist, end - start);
+    if (an->windowNs > 0) {
+        _logger_histAdd(_logger_windowGet(&pair->windows, floorDiv(start, an->windowNs)), end - start);
+    }
+    if (pair->hist.count == 1 || start < pair->first) pair->first = start;
+    if (pair->hist.count == 1 || start > pair->last) pair->last = start;
+    if (an->diffFile != NULL) {
+        fprintf(an->diffFile, "%s;%s;%.12f\n", pair->startName, pair->endName, (double)(end - start) / 1e6);
+    }
+}
+
+// Streams one capture. The memory use only depends on the count of tags, pairs and open spans.
+static int analyzeCapture(analyze_t *an, const char *fileName) {
+    capture_t cap;
+    int ret = capture_open(&cap, fileName);
+    if (ret != 0) {
+        return ret;
+    }
+    if (!an->exportStarted) {
+        an->clockType = cap.clockType;
+    }
+    analyze_tag_t *tags = NULL;
+    int tagSize = 0;
+    capture_entry_t entry;
+    while ((ret = capture_next(&cap, &entry)) == 1) {
+        if (!listPasses(an, entry.list)) {
+            continue;
+        }
+        if (entry.tag >= tagSize) {
+            tags = (analyze_tag_t *)realloc(tags, sizeof(analyze_tag_t) * (entry.tag + 1));
+            memset(tags + tagSize, 0, sizeof(analyze_tag_t) * (entry.tag + 1 - tagSize));
+            tagSize = entry.tag + 1;
+        }
+        analyze_tag_t *tag = &tags[entry.tag];
+        if (!tag->resolved) {
+            resolveTag(an, tag, capture_tagName(&cap, entry.tag));
+        }
+        if (!tag->pass) {
+            continue;
+        }
+        if (an->exportFile != NULL) {
+            exportEntry(an, capture_tagName(&cap, entry.tag), &entry);
+        }
+        for (int r = 0; r < tag->roleCount; r++) {
+            analyze_pair_t *pair = &an->pairs[tag->roles[r] / 2];
+            if (tag->roles[r] % 2) {
+                openSpan(an, pair, &entry);
+                continue;
+            }
+            int64_t start;
+            if (capture_idMapTake(&pair->open, entry.id, &start)) {
+                addSpan(an, pair, start, entry.time);
+            }
+        }
+    }
+    for (int t = 0; t < tagSize; t++) {
+        free(tags[t].roles);
+    }
+    free(tags);
+    capture_close(&cap);
+    return ret < 0 ? ret : 0;
+}
+
+static void report(analyze_t *an, FILE *pCsvFile, FILE *pJsonFile) {
+    if (pCsvFile != NULL) {
+        fprintf(pCsvFile, "\n");
+        fprintf(pCsvFile, "TAGS;COUNT;MIN;MAX;AVG;MEDIAN;RATE;P90;P99;P999\n");
+    }
+    if (pJsonFile != NULL) {
+        fprintf(pJsonFile, "\n");
+        fprintf(pJsonFile, "{\"data\":[\n");
+    }
+    for (int c = 0; c < an->count; c++) {
+        analyze_pair_t *pair = &an->pairs[c];
+        _logger_hist_t *hist = &pair->hist;
+        unsigned long count = (unsigned long)hist->count;
+        double min = (double)hist->min / 1e6;
+        double max = (double)hist->max / 1e6;
+        double mean = count > 0 ? hist->sum / (double)count / 1e6 : 0.0;
+        double median = (double)_logger_histQuantile(hist, 0.5) / 1e6;
+        double p90 = (double)_logger_histQuantile(hist, 0.9) / 1e6;
+        double p99 = (double)_logger_histQuantile(hist, 0.99) / 1e6;
+        double p999 = (double)_logger_histQuantile(hist, 0.999) / 1e6;
+        double duration_ms = (double)(pair->last - pair->first) / 1e6;
+        double rate = duration_ms > 0.0 ? (double)count / duration_ms * 1000.0 : 0.0;
+        if (pair->dropped > 0 || pair->open.count > 0) {
+            fprintf(stderr, "[Warning] %s: %ld START entries without END\n", pair->name,
+                    pair->dropped + pair->open.count);
+        }
+        if (pCsvFile == NULL && pJsonFile == NULL) {
+            printf("%s-%s | Count:%lu Min:%.5fms Max:%.5fms Mean:%.5fms Median:%.5fms P90:%.5fms P99:%.5fms "
+                   "P99.9:%.5fms Rate:%.2f/s\n",
+                   pair->startName, pair->endName, count, min, max, mean, median, p90, p99, p999, rate);
+        }
+        if (pCsvFile != NULL) {
+            fprintf(pCsvFile, "%s-%s;%lu;%.10f;%.10f;%.10f;%.10f;%.5f;%.10f;%.10f;%.10f\n", pair->startName,
+                    pair->endName, count, min, max, mean, median, rate, p90, p99, p999);
+        }
+        if (pJsonFile != NULL) {
+            fprintf(pJsonFile, "\t{\n");
+            fprintf(pJsonFile, "\t\t\"name\":\"%s-%s\",\n", pair->startName, pair->endName);
+            fprintf(pJsonFile, "\t\t\"count\":%lu,\n", count);
+            fprintf(pJsonFile, "\t\t\"min\":%.10f,\n", min);
+            fprintf(pJsonFile, "\t\t\"max\":%.10f,\n", max);
+            fprintf(pJsonFile, "\t\t\"mean\":%.10f,\n", mean);
+            fprintf(pJsonFile, "\t\t\"median\":%.10f,\n", median);
+            fprintf(pJsonFile, "\t\t\"rate\":%.5f,\n", rate);
+            fprintf(pJsonFile, "\t\t\"p90\":%.10f,\n", p90);
+            fprintf(pJsonFile, "\t\t\"p99\":%.10f,\n", p99);
+            fprintf(pJsonFile, "\t\t\"p999\":%.10f\n", p999);
+            fprintf(pJsonFile, "\t}");
+            if (c < (an->count - 1)) fprintf(pJsonFile, ",");
+            fprintf(pJsonFile, "\n");
+        }
+    }
+    if (pJsonFile != NULL) {
+        fprintf(pJsonFile, "]}");
+    }
+}
+
+// Writes the windows of all pairs in the format of logger_evaluate_windowed
+static void reportWindows(analyze_t *an, FILE *pCsvFile, FILE *pJsonFile) {
+    if (pCsvFile != NULL) {
+        fprintf(pCsvFile, "TAGS;WINDOW_START;WALL_START;COUNT;MIN;MAX;P50;P99\n");
+    }
+    if (pJsonFile != NULL) {
+        fprintf(pJsonFile, "{\"window_ns\":%lld,\"data\":[\n", (long long)an->windowNs);
+    }
+    for (int c = 0; c < an->count; c++) {
+        analyze_pair_t *pair = &an->pairs[c];
+        if (pJsonFile != NULL) {
+            fprintf(pJsonFile, "\t{\n");
+            fprintf(pJsonFile, "\t\t\"name\":\"%s-%s\",\n", pair->startName, pair->endName);
+            fprintf(pJsonFile, "\t\t\"windows\":[\n");
+        }
+        // Windows without spans are left out. The captures have no wall clock offset, so WALL_START is empty.
+        int first = 1;
+        _logger_windowMap_t *map = &pair->windows;
+        int64_t *order = _logger_windowOrder(map);
+        for (long w = 0; w < map->count; w++) {
+            const _logger_hist_t *hist = &map->hists[_logger_windowSlot(map, order[w])];
+            char start[32];
+            capture_formatTime(start, sizeof(start), order[w] * an->windowNs);
+            double min = (double)hist->min / 1e6;
+            double max = (double)hist->max / 1e6;
+            double p50 = (double)_logger_histQuantile(hist, 0.5) / 1e6;
+            double p99 = (double)_logger_histQuantile(hist, 0.99) / 1e6;
+            if (pCsvFile == NULL && pJsonFile == NULL) {
+                printf("%s-%s | Window:%s Wall:- Count:%lu Min:%.5fms Max:%.5fms P50:%.5fms P99:%.5fms\n",
+                       pair->startName, pair->endName, start, (unsigned long)hist->count, min, max, p50, p99);
+            }
+            if (pCsvFile != NULL) {
+                fprintf(pCsvFile, "%s-%s;%s;;%lu;%.10f;%.10f;%.10f;%.10f\n", pair->startName, pair->endName, start,
+                        (unsigned long)hist->count, min, max, p50, p99);
+            }
+            if (pJsonFile != NULL) {
+                fprintf(pJsonFile,
+                        "%s\t\t\t{\"start\":%s,\"count\":%lu,\"min\":%.10f,\"max\":%.10f,\"p50\":%.10f,"
+                        "\"p99\":%.10f}",
+                        first ? "" : ",\n", start, (unsigned long)hist->count, min, max, p50, p99);
+            }
+            first = 0;
+        }
+        free(order);
+        if (pJsonFile != NULL && !first) {
+            fprintf(pJsonFile, "\n");
+        }
+        if (pJsonFile != NULL) {
+            fprintf(pJsonFile, "\t\t]\n");
+            fprintf(pJsonFile, "\t}");
+            if (c < (an->count - 1)) fprintf(pJsonFile, ",");
+            fprintf(pJsonFile, "\n");
+        }
+    }
+    if (pJsonFile != NULL) {
+        fprintf(pJsonFile, "]}");
+    }
+}
+
+static FILE *openOutput(const char *fileName) {
+    if (fileName == NULL) {
+        return NULL;
+    }
+    FILE *pFile = fopen(fileName, "w");
+    if (!pFile) {
+        fprintf(stderr, "[Error] Could not open %s: %s\n", fileName, strerror(errno));
+    }
+    return pFile;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage: rtperflog-analyze [options] <capture>...\n"
+            "  Evaluates the spans of captures (CSV export or binary capture) in one streaming pass. The captures are\n"
+            "  read one after another, so a span can start in one capture and end in the next one.\n"
+            "  -p <PAIR>|<START>:<END>  Evaluate a tag pair (repeatable). Default: every <PAIR>_START/<PAIR>_END pair\n"
+            "  -l <list>                Only use entries of a list (repeatable). CSV exports without a list\n"
+            "                           column are list 0\n"
+            "  -t <tag>                 Only use entries of a tag (repeatable)\n"
+            "  -o <file.csv>            Write the evaluation to a CSV file (like logger_evaluate)\n"
+            "  -j <file.json>           Write the evaluation to a JSON file (like logger_evaluate)\n"
+            "  -d <file.csv>            Write the duration of every span (like logger_evaluate_diff)\n"
+            "  -e <file.csv>            Export the filtered entries (like logger_writeListToCSV)\n"
+            "  -w <ms>                  Evaluate the spans in windows of their start time (like\n"
+            "                           logger_evaluate_windowed), -o and -j write the time series\n"
+            "  -m <count>               Maximum open spans per pair (default %d)\n",
+            ANALYZE_MAX_OPEN);
+}
+
+int main(int argc, char **argv) {
+    analyze_t an;
+    memset(&an, 0, sizeof(an));
+    an.maxOpen = ANALYZE_MAX_OPEN;
+    const char *csvName = NULL;
+    const char *jsonName = NULL;
+    const char *diffName = NULL;
+    const char *exportName = NULL;
+    const char **files = (const char **)malloc(sizeof(char *) * (size_t)argc);
+    int fileCount = 0;
+    int ret = 0;
+    for (int i = 1; i < argc && ret == 0; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            parsePair(&an, argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            an.lists = (int *)realloc(an.lists, sizeof(int) * (an.listCount + 1));
+            an.lists[an.listCount++] = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            an.tags = (char **)realloc(an.tags, sizeof(char *) * (an.tagCount + 1));
+            an.tags[an.tagCount++] = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            csvName = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jsonName = argv[++i];
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            diffName = argv[++i];
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            exportName = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            an.windowNs = (int64_t)(atof(argv[++i]) * 1e6);
+            if (an.windowNs <= 0) ret = -1;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            an.maxOpen = atol(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            files[fileCount++] = argv[i];
+        } else {
+            ret = -1;
+        }
+    }
+    if (ret != 0 || fileCount == 0 || an.maxOpen <= 0) {
+        usage();
+        free(files);
+        free(an.lists);
+        free(an.tags);
+        free(an.pairs);
+        return 2;
+    }
+
+    FILE *pCsvFile = openOutput(csvName);
+    FILE *pJsonFile = openOutput(jsonName);
+    an.diffFile = openOutput(diffName);
+    an.exportFile = openOutput(exportName);
+    if ((csvName != NULL && pCsvFile == NULL) || (jsonName != NULL && pJsonFile == NULL) ||
+        (diffName != NULL && an.diffFile == NULL) || (exportName != NULL && an.exportFile == NULL)) {
+        ret = -2;
+    }
+    if (an.diffFile != NULL) {
+        fprintf(an.diffFile, "\n");
+        fprintf(an.diffFile, "TAGS;DIFF\n");
+    }
+    for (int f = 0; f < fileCount && ret == 0; f++) {
+        ret = analyzeCapture(&an, files[f]);
+    }
+    if (ret == 0 && an.windowNs > 0) {
+        reportWindows(&an, pCsvFile, pJsonFile);
+    } else if (ret == 0) {
+        report(&an, pCsvFile, pJsonFile);
+    }
+
+    if (pCsvFile != NULL) fclose(pCsvFile);
+    if (pJsonFile != NULL) fclose(pJsonFile);
+    if (an.diffFile != NULL) fclose(an.diffFile);
+    if (an.exportFile != NULL) fclose(an.exportFile);
+    for (int c = 0; c < an.count; c++) {
+        capture_idMapFree(&an.pairs[c].open);
+        free(an.pairs[c].order);
+        _logger_histFree(&an.pairs[c].hist);
+        _logger_windowMapFree(&an.pairs[c].windows);
+    }
+    free(an.pairs);
+    free(an.lists);
+    free(an.tags);
+    free(files);
+    return ret == 0 ? 0 : 2;
+}
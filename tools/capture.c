@@ -0,0 +1,444 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains the streaming capture reader used by the rtperflog tools.
+ */
+// 64 bit file offsets on 32 bit targets, so captures larger than 2 GiB can be sought
+#define _FILE_OFFSET_BITS 64
+#include "capture.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "loggerFormat.h"
+#include "loggerUtil.h"
+
+// Size of the stdio buffer of CSV captures and count of records per read of binary captures
+#define CAPTURE_CHUNK (1 << 16)
+#define CAPTURE_RECORDS 4096
+#define CAPTURE_LINE 512
+// Upper bound of the tag numbers of a binary capture, which guards the tag map against corrupt files
+#define CAPTURE_TAG_MAX (1 << 24)
+
+// File positions of 64 bits, also where long has 32 bits
+#if defined(_WIN32)
+#define _capture_fseek(file, pos) _fseeki64(file, (__int64)(pos), SEEK_SET)
+#define _capture_ftell(file) ((int64_t)_ftelli64(file))
+#else
+#include <sys/types.h>
+#define _capture_fseek(file, pos) fseeko(file, (off_t)(pos), SEEK_SET)
+#define _capture_ftell(file) ((int64_t)ftello(file))
+#endif
+
+static void _capture_rehash(capture_t *cap, int size) {
+    free(cap->nameHash);
+    cap->nameHashSize = size;
+    cap->nameHash = (int *)malloc(sizeof(int) * size);
+    for (int i = 0; i < size; i++) {
+        cap->nameHash[i] = -1;
+    }
+    for (int n = 0; n < cap->nameCount; n++) {
+        int slot = (int)(_logger_hashName(cap->names[n]) & (uint64_t)(size - 1));
+        while (cap->nameHash[slot] >= 0) {
+            slot = (slot + 1) & (size - 1);
+        }
+        cap->nameHash[slot] = n;
+    }
+}
+
+int capture_internTag(capture_t *cap, const char *name) {
+    if (cap->nameHashSize == 0) {
+        _capture_rehash(cap, 64);
+    }
+    int slot = (int)(_logger_hashName(name) & (uint64_t)(cap->nameHashSize - 1));
+    while (cap->nameHash[slot] >= 0) {
+        if (strcmp(cap->names[cap->nameHash[slot]], name) == 0) {
+            return cap->nameHash[slot];
+        }
+        slot = (slot + 1) & (cap->nameHashSize - 1);
+    }
+    cap->names = (char **)realloc(cap->names, sizeof(char *) * (cap->nameCount + 1));
+    cap->names[cap->nameCount] = (char *)malloc(strlen(name) + 1);
+    strcpy(cap->names[cap->nameCount], name);
+    cap->nameHash[slot] = cap->nameCount;
+    cap->nameCount++;
+    if (cap->nameCount * 2 > cap->nameHashSize) {
+        _capture_rehash(cap, cap->nameHashSize * 2);
+    }
+    return cap->nameCount - 1;
+}
+
+const char *capture_tagName(const capture_t *cap, int tag) {
+    if (tag < 0 || tag >= cap->nameCount) {
+        return "";
+    }
+    return cap->names[tag];
+}
+
+static int _capture_openBinary(capture_t *cap) {
+    _logger_fileHeader_t header;
+    if (fread(&header, sizeof(header), 1, cap->file) != 1 || header.version < 1 ||
+        header.version > LOGGER_FILE_VERSION) {
+        fprintf(stderr, "[Error] %s: unsupported binary capture\n", cap->fileName);
+        return -3;
+    }
+    cap->binary = 1;
+    cap->version = (int)header.version;
+    cap->recordSize = cap->version == 1 ? sizeof(_logger_fileEntryV1_t) : sizeof(_logger_fileEntry_t);
+    cap->clockType = header.clockType;
+    cap->entryCount = header.entryCount;
+    cap->remaining = header.entryCount;
+    for (int k = 0; k < header.tagCount; k++) {
+        _logger_fileTag_t tag;
+        if (fread(&tag, sizeof(tag), 1, cap->file) != 1 || tag.tag < 0 || tag.tag >= CAPTURE_TAG_MAX) {
+            fprintf(stderr, "[Error] %s: invalid tag table\n", cap->fileName);
+            return -3;
+        }
+        tag.info[LOGGER_TAG_INFO_MAXLEN - 1] = '\0';
+        if (tag.tag >= cap->tagMapSize) {
+            cap->tagMap = (int *)realloc(cap->tagMap, sizeof(int) * (tag.tag + 1));
+            for (int i = cap->tagMapSize; i <= tag.tag; i++) {
+                cap->tagMap[i] = -1;
+            }
+            cap->tagMapSize = tag.tag + 1;
+        }
+        cap->tagMap[tag.tag] = capture_internTag(cap, tag.info);
+    }
+    cap->dataOffset = _capture_ftell(cap->file);
+    cap->buffer = (char *)malloc(cap->recordSize * CAPTURE_RECORDS);
+    return 0;
+}
+
+// Reads the metadata line of a CSV export: #rtperflog;version=1;clock=1;base_sec=5321;pid=4711
+static void _capture_readMetadata(capture_t *cap) {
+    char line[CAPTURE_LINE];
+    int64_t pos = _capture_ftell(cap->file);
+    if (fgets(line, sizeof(line), cap->file) == NULL || strncmp(line, "#rtperflog", 10) != 0) {
+        _capture_fseek(cap->file, pos);
+        return;
+    }
+    cap->line++;
+    for (char *key = strtok(line, ";\r\n"); key != NULL; key = strtok(NULL, ";\r\n")) {
+        char *value = strchr(key, '=');
+        if (value == NULL) {
+            continue;
+        }
+        *value++ = '\0';
+        if (strcmp(key, "version") == 0) {
+            cap->version = atoi(value);
+        } else if (strcmp(key, "clock") == 0) {
+            cap->clockType = atoi(value);
+        } else if (strcmp(key, "base_sec") == 0) {
+            cap->base = strtoll(value, NULL, 10) * 1000000000LL;
+        } else if (strcmp(key, "pid") == 0) {
+            cap->pid = strtol(value, NULL, 10);
+        }
+    }
+    if (cap->version > LOGGER_CSV_VERSION) {
+        fprintf(stderr, "[Warning] %s: CSV layout version %d is newer than %d\n", cap->fileName, cap->version,
+                LOGGER_CSV_VERSION);
+    }
+}
+
+int capture_open(capture_t *cap, const char *fileName) {
+    memset(cap, 0, sizeof(capture_t));
+    cap->file = fopen(fileName, "rb");
+    if (!cap->file) {
+        fprintf(stderr, "[Error] Could not open %s: %s\n", fileName, strerror(errno));
+        return -2;
+    }
+    cap->clockType = -1;
+    cap->pid = -1;
+    cap->fileName = (char *)malloc(strlen(fileName) + 1);
+    strcpy(cap->fileName, fileName);
+    char magic[4];
+    if (fread(magic, 1, sizeof(magic), cap->file) == sizeof(magic) &&
+        memcmp(magic, LOGGER_FILE_MAGIC, sizeof(magic)) == 0) {
+        rewind(cap->file);
+        int ret = _capture_openBinary(cap);
+        if (ret != 0) {
+            capture_close(cap);
+        }
+        return ret;
+    }
+    rewind(cap->file);
+    setvbuf(cap->file, NULL, _IOFBF, CAPTURE_CHUNK);
+    _capture_readMetadata(cap);
+    return 0;
+}
+
+int64_t capture_tell(capture_t *cap) {
+    if (cap->binary) {
+        return cap->entryCount - cap->remaining - (cap->bufferCount - cap->bufferPos);
+    }
+    return _capture_ftell(cap->file);
+}
+
+int capture_seek(capture_t *cap, int64_t pos) {
+    if (cap->binary) {
+        cap->remaining = cap->entryCount - pos;
+        cap->bufferCount = 0;
+        cap->bufferPos = 0;
+        pos = cap->dataOffset + pos * (int64_t)cap->recordSize;
+    }
+    if (_capture_fseek(cap->file, pos) != 0) {
+        fprintf(stderr, "[Error] %s: %s\n", cap->fileName, strerror(errno));
+        return -2;
+    }
+    return 0;
+}
+
+// Parses the time column of a CSV export: <seconds>.<nanoseconds with 9 digits>. The nanoseconds are always added,
+// like the fields of a timespec, so -1.250000000 is -0.75 s.
+static int _capture_parseTime(const char *str, int64_t *time) {
+    char *end;
+    long long sec = strtoll(str, &end, 10);
+    int64_t nsec = 0;
+    if (end == str) {
+        return -1;
+    }
+    if (*end == '.') {
+        int digits = 0;
+        end++;
+        while (*end >= '0' && *end <= '9' && digits < 9) {
+            nsec = nsec * 10 + (*end - '0');
+            end++;
+            digits++;
+        }
+        for (; digits < 9; digits++) {
+            nsec *= 10;
+        }
+    }
+    *time = (int64_t)sec * 1000000000LL + nsec;
+    return 0;
+}
+
+static int _capture_nextCsv(capture_t *cap, capture_entry_t *entry) {
+    char line[CAPTURE_LINE];
+    while (fgets(line, sizeof(line), cap->file) != NULL) {
+        cap->line++;
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '#' || line[0] == '\0') {
+            continue;
+        }
+        char *id = strchr(line, ',');
+        char *time = id != NULL ? strchr(id + 1, ',') : NULL;
+        if (time == NULL) {
+            fprintf(stderr, "[Error] %s:%ld: invalid line\n", cap->fileName, cap->line);
+            return -3;
+        }
+        *id++ = '\0';
+        *time++ = '\0';
+        // Optional fourth column: the CPU, which is empty when it was not recorded. Optional fifth column: the list,
+        // which rtperflog-merge writes.
+        char *cpu = strchr(time, ',');
+        char *list = NULL;
+        if (cpu != NULL) {
+            *cpu++ = '\0';
+            list = strchr(cpu, ',');
+            if (list != NULL) {
+                *list++ = '\0';
+            }
+        }
+        entry->tag = capture_internTag(cap, line);
+        entry->list = list != NULL ? atoi(list) : 0;
+        entry->cpu = cpu != NULL && *cpu >= '0' && *cpu <= '9' ? atoi(cpu) : -1;
+        entry->id = strtoul(id, NULL, 10);
+        if (_capture_parseTime(time, &entry->time) != 0) {
+            fprintf(stderr, "[Error] %s:%ld: invalid time\n", cap->fileName, cap->line);
+            return -3;
+        }
+        entry->time += cap->base;
+        return 1;
+    }
+    return 0;
+}
+
+static int _capture_nextBinary(capture_t *cap, capture_entry_t *entry) {
+    if (cap->bufferPos >= cap->bufferCount) {
+        if (cap->remaining <= 0) {
+            return 0;
+        }
+        int64_t count = cap->remaining < CAPTURE_RECORDS ? cap->remaining : CAPTURE_RECORDS;
+        cap->bufferCount = (int)fread(cap->buffer, cap->recordSize, (size_t)count, cap->file);
+        cap->bufferPos = 0;
+        if (cap->bufferCount == 0) {
+            fprintf(stderr, "[Error] %s: truncated capture\n", cap->fileName);
+            return -3;
+        }
+        cap->remaining -= cap->bufferCount;
+    }
+    const char *raw = cap->buffer + cap->recordSize * cap->bufferPos++;
+    _logger_fileEntry_t rec;
+    if (cap->version == 1) {
+        _logger_fileEntryV1_t old;
+        memcpy(&old, raw, sizeof(old));
+        rec.tag = old.tag;
+        rec.list = old.list;
+        rec.cpu = -1;
+        rec.id = old.id;
+        rec.time = old.time;
+    } else {
+        memcpy(&rec, raw, sizeof(rec));
+    }
+    if (rec.tag >= 0 && rec.tag < cap->tagMapSize && cap->tagMap[rec.tag] >= 0) {
+        entry->tag = cap->tagMap[rec.tag];
+    } else {
+        // Tag without a name, use its number
+        char name[16];
+        snprintf(name, sizeof(name), "%d", rec.tag);
+        entry->tag = capture_internTag(cap, name);
+    }
+    entry->list = rec.list;
+    entry->cpu = rec.cpu;
+    entry->id = (unsigned long)rec.id;
+    entry->time = rec.time;
+    return 1;
+}
+
+int capture_next(capture_t *cap, capture_entry_t *entry) {
+    if (cap->binary) {
+        return _capture_nextBinary(cap, entry);
+    }
+    return _capture_nextCsv(cap, entry);
+}
+
+void capture_close(capture_t *cap) {
+    if (cap->file != NULL) {
+        fclose(cap->file);
+    }
+    for (int n = 0; n < cap->nameCount; n++) {
+        free(cap->names[n]);
+    }
+    free(cap->names);
+    free(cap->nameHash);
+    free(cap->tagMap);
+    free(cap->buffer);
+    free(cap->fileName);
+    memset(cap, 0, sizeof(capture_t));
+}
+
+void capture_formatTime(char *buffer, int bufferSize, int64_t time) {
+    int64_t sec = time / 1000000000LL;
+    int64_t nsec = time % 1000000000LL;
+    if (nsec < 0) {
+        sec--;
+        nsec += 1000000000LL;
+    }
+    snprintf(buffer, (size_t)bufferSize, "%lld.%09lld", (long long)sec, (long long)nsec);
+}
+
+int capture_splitTag(const char *name, char *pairName, int pairNameSize, int *isStart) {
+    size_t len = strlen(name);
+    size_t prefix;
+    if (len > 6 && strcmp(name + len - 6, "_START") == 0) {
+        prefix = len - 6;
+        *isStart = 1;
+    } else if (len > 4 && strcmp(name + len - 4, "_END") == 0) {
+        prefix = len - 4;
+        *isStart = 0;
+    } else {
+        return -1;
+    }
+    if (prefix >= (size_t)pairNameSize) {
+        return -1;
+    }
+    memcpy(pairName, name, prefix);
+    pairName[prefix] = '\0';
+    return 0;
+}
+
+void capture_idMapInit(capture_idMap_t *map) {
+    map->size = 1024;
+    map->count = 0;
+    map->ids = (unsigned long *)malloc(sizeof(unsigned long) * map->size);
+    map->times = (int64_t *)malloc(sizeof(int64_t) * map->size);
+    map->used = (char *)calloc(map->size, sizeof(char));
+}
+
+void capture_idMapFree(capture_idMap_t *map) {
+    free(map->ids);
+    free(map->times);
+    free(map->used);
+    memset(map, 0, sizeof(capture_idMap_t));
+}
+
+static long _capture_idHome(const capture_idMap_t *map, unsigned long id) {
+    return (long)(((uint64_t)id * 0x9E3779B97F4A7C15ull) >> 20 & (uint64_t)(map->size - 1));
+}
+
+static long _capture_idSlot(const capture_idMap_t *map, unsigned long id) {
+    long slot = _capture_idHome(map, id);
+    while (map->used[slot] && map->ids[slot] != id) {
+        slot = (slot + 1) & (map->size - 1);
+    }
+    return slot;
+}
+
+void capture_idMapPut(capture_idMap_t *map, unsigned long id, int64_t time) {
+    if ((map->count + 1) * 2 > map->size) {
+        capture_idMap_t grown;
+        grown.size = map->size * 2;
+        grown.count = 0;
+        grown.ids = (unsigned long *)malloc(sizeof(unsigned long) * grown.size);
+        grown.times = (int64_t *)malloc(sizeof(int64_t) * grown.size);
+        grown.used = (char *)calloc(grown.size, sizeof(char));
+        for (long i = 0; i < map->size; i++) {
+            if (map->used[i]) {
+                capture_idMapPut(&grown, map->ids[i], map->times[i]);
+            }
+        }
+        capture_idMapFree(map);
+        *map = grown;
+    }
+    long slot = _capture_idSlot(map, id);
+    if (!map->used[slot]) {
+        map->used[slot] = 1;
+        map->ids[slot] = id;
+        map->count++;
+    }
+    map->times[slot] = time;
+}
+
+int capture_idMapGet(const capture_idMap_t *map, unsigned long id, int64_t *time) {
+    long slot = _capture_idSlot(map, id);
+    if (!map->used[slot]) {
+        return 0;
+    }
+    *time = map->times[slot];
+    return 1;
+}
+
+int capture_idMapTake(capture_idMap_t *map, unsigned long id, int64_t *time) {
+    long slot = _capture_idSlot(map, id);
+    if (!map->used[slot]) {
+        return 0;
+    }
+    *time = map->times[slot];
+    // Backward shift deletion keeps the probe sequences intact
+    map->used[slot] = 0;
+    map->count--;
+    long next = (slot + 1) & (map->size - 1);
+    while (map->used[next]) {
+        long home = _capture_idHome(map, map->ids[next]);
+        if (((next - home) & (map->size - 1)) >= ((next - slot) & (map->size - 1))) {
+            map->ids[slot] = map->ids[next];
+            map->times[slot] = map->times[next];
+            map->used[slot] = 1;
+            map->used[next] = 0;
+            slot = next;
+        }
+        next = (next + 1) & (map->size - 1);
+    }
+    return 1;
+}
@@ -0,0 +1,165 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains the streaming capture reader used by the rtperflog tools.
+ */
+
+#ifndef RTPERFLOG_CAPTURE_H
+#define RTPERFLOG_CAPTURE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Maximum length of a tag or tag pair name in the tools
+#define CAPTURE_NAME_MAX 256
+
+/**
+ * One entry of a capture.
+ * @property {int} tag - Index into the tag name table of the capture. See `capture_tagName`.
+ * @property {int} list - The list number. The entries of a CSV export without a list column are in list 0.
+ * @property {int} cpu - The CPU of the probe or -1, when it was not recorded.
+ * @property {unsigned long} id - The id of the entry.
+ * @property {int64_t} time - The timestamp in nanoseconds.
+ */
+typedef struct {
+    int tag;
+    int list;
+    int cpu;
+    unsigned long id;
+    int64_t time;
+} capture_entry_t;
+
+/**
+ * A capture opened for streaming. It reads either a binary capture of `logger_writeToBinary` or a CSV export of
+ * `logger_writeToCSV` in chunks, so the memory use does not depend on the capture size. The timestamps are absolute,
+ * when the CSV export has a metadata line.
+ * @property {int} clockType - The logger_clockType_t of the capture or -1, when it is unknown.
+ * @property {int64_t} base - The time base in nanoseconds, which is added to the timestamps of a CSV export.
+ * @property {long} pid - The process id of a CSV export or -1.
+ */
+typedef struct {
+    FILE *file;
+    char *fileName;
+    int binary;
+    int version;
+    int clockType;
+    int64_t base;
+    long pid;
+    int64_t entryCount;
+    int64_t dataOffset;
+    size_t recordSize;
+    int64_t remaining;
+    // Interned tag names
+    char **names;
+    int nameCount;
+    int *nameHash;
+    int nameHashSize;
+    // Binary captures: tag of the file -> name index
+    int *tagMap;
+    int tagMapSize;
+    char *buffer;
+    int bufferCount;
+    int bufferPos;
+    long line;
+} capture_t;
+
+/**
+ * Opens a capture. The format is detected by the file content.
+ *
+ * @return 0=success;-2=file error;-3=format error
+ */
+int capture_open(capture_t *cap, const char *fileName);
+
+/**
+ * Reads the next entry of a capture.
+ *
+ * @return 1=entry read;0=end of capture;-3=format error
+ */
+int capture_next(capture_t *cap, capture_entry_t *entry);
+
+/**
+ * Returns the position of the next entry. It can be passed to `capture_seek` of a capture of the same file.
+ */
+int64_t capture_tell(capture_t *cap);
+
+/**
+ * Continues reading at a position returned by `capture_tell`.
+ *
+ * @return 0=success;-2=file error
+ */
+int capture_seek(capture_t *cap, int64_t pos);
+
+/**
+ * Closes the capture and frees its memory.
+ */
+void capture_close(capture_t *cap);
+
+/**
+ * Returns the name of a tag index.
+ */
+const char *capture_tagName(const capture_t *cap, int tag);
+
+/**
+ * Returns the index of a tag name. The name is added to the table, when it is not known yet.
+ */
+int capture_internTag(capture_t *cap, const char *name);
+
+/**
+ * Formats a time in nanoseconds like the time column of a CSV export: <seconds>.<nanoseconds with 9 digits>. The
+ * nanoseconds are not negative, like the fields of a timespec.
+ */
+void capture_formatTime(char *buffer, int bufferSize, int64_t time);
+
+/**
+ * Splits a tag name of the form <PAIR>_START or <PAIR>_END, as generated by GENERATE_DEF.
+ *
+ * @param name The tag name.
+ * @param pairName Buffer of pairNameSize bytes for <PAIR>.
+ * @param isStart Set to 1 for _START and to 0 for _END.
+ *
+ * @return 0=success;-1=the name does not belong to a tag pair
+ */
+int capture_splitTag(const char *name, char *pairName, int pairNameSize, int *isStart);
+
+/**
+ * Hash map from an id to a timestamp. It is used to match START and END entries by their id across all lists, like
+ * logger_evaluate, so a span may start in one list or process and end in another one.
+ */
+typedef struct {
+    unsigned long *ids;
+    int64_t *times;
+    char *used;
+    long size;
+    long count;
+} capture_idMap_t;
+
+void capture_idMapInit(capture_idMap_t *map);
+void capture_idMapFree(capture_idMap_t *map);
+/**
+ * Inserts or replaces the timestamp of an id.
+ */
+void capture_idMapPut(capture_idMap_t *map, unsigned long id, int64_t time);
+/**
+ * Looks up the timestamp of an id.
+ *
+ * @return 1=found and time is set;0=not found
+ */
+int capture_idMapGet(const capture_idMap_t *map, unsigned long id, int64_t *time);
+/**
+ * Removes an id from the map.
+ *
+ * @return 1=found and time is set;0=not found
+ */
+int capture_idMapTake(capture_idMap_t *map, unsigned long id, int64_t *time);
+
+#endif  // RTPERFLOG_CAPTURE_H
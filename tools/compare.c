@@ -0,0 +1,249 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains rtperflog-compare, which compares the spans of two captures.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture.h"
+#include "loggerUtil.h"
+#include "stats.h"
+
+typedef struct {
+    char name[CAPTURE_NAME_MAX];
+    capture_idMap_t open;
+    double *samples;
+    long count;
+    long size;
+} compare_pair_t;
+
+typedef struct {
+    compare_pair_t *pairs;
+    int count;
+} compare_run_t;
+
+static int findPair(compare_run_t *run, const char *name, int create) {
+    for (int i = 0; i < run->count; i++) {
+        if (strcmp(run->pairs[i].name, name) == 0) {
+            return i;
+        }
+    }
+    if (!create) {
+        return -1;
+    }
+    run->pairs = (compare_pair_t *)realloc(run->pairs, sizeof(compare_pair_t) * (run->count + 1));
+    compare_pair_t *pair = &run->pairs[run->count];
+    memset(pair, 0, sizeof(compare_pair_t));
+    snprintf(pair->name, sizeof(pair->name), "%s", name);
+    capture_idMapInit(&pair->open);
+    return run->count++;
+}
+
+// Reads all spans of a capture. START and END entries are matched by the tag pair name and the id across all lists,
+// like logger_evaluate.
+static int loadRun(const char *fileName, compare_run_t *run) {
+    capture_t cap;
+    int ret = capture_open(&cap, fileName);
+    if (ret != 0) {
+        return ret;
+    }
+    // tag index -> pair index (-2 = not known yet, -1 = no pair)
+    int *pairOf = NULL;
+    int *startOf = NULL;
+    int pairOfSize = 0;
+    capture_entry_t entry;
+    while ((ret = capture_next(&cap, &entry)) == 1) {
+        if (entry.tag >= pairOfSize) {
+            pairOf = (int *)realloc(pairOf, sizeof(int) * (entry.tag + 1));
+            startOf = (int *)realloc(startOf, sizeof(int) * (entry.tag + 1));
+            for (int i = pairOfSize; i <= entry.tag; i++) {
+                pairOf[i] = -2;
+            }
+            pairOfSize = entry.tag + 1;
+        }
+        if (pairOf[entry.tag] == -2) {
+            char name[CAPTURE_NAME_MAX];
+            if (capture_splitTag(capture_tagName(&cap, entry.tag), name, sizeof(name), &startOf[entry.tag]) == 0) {
+                pairOf[entry.tag] = findPair(run, name, 1);
+            } else {
+                pairOf[entry.tag] = -1;
+            }
+        }
+        if (pairOf[entry.tag] < 0) {
+            continue;
+        }
+        compare_pair_t *pair = &run->pairs[pairOf[entry.tag]];
+        if (startOf[entry.tag]) {
+            capture_idMapPut(&pair->open, entry.id, entry.time);
+            continue;
+        }
+        int64_t start;
+        if (!capture_idMapTake(&pair->open, entry.id, &start)) {
+            continue;
+        }
+        if (pair->count >= pair->size) {
+            pair->size = pair->size == 0 ? 1024 : pair->size * 2;
+            pair->samples = (double *)realloc(pair->samples, sizeof(double) * pair->size);
+        }
+        pair->samples[pair->count++] = (double)(entry.time - start) / 1e6;
+    }
+    free(pairOf);
+    free(startOf);
+    capture_close(&cap);
+    for (int i = 0; i < run->count; i++) {
+        capture_idMapFree(&run->pairs[i].open);
+        qsort(run->pairs[i].samples, run->pairs[i].count, sizeof(double), _logger_compareDouble);
+    }
+    return ret < 0 ? ret : 0;
+}
+
+static void freeRun(compare_run_t *run) {
+    for (int i = 0; i < run->count; i++) {
+        free(run->pairs[i].samples);
+    }
+    free(run->pairs);
+}
+
+// Writes a CSV row of a pair without a comparison. Only the counts and the result are set.
+static void writeUnmatched(FILE *pFile, const char *name, long countA, long countB, const char *result) {
+    if (pFile == NULL) {
+        return;
+    }
+    fprintf(pFile, "%s;%ld;%ld;", name, countA, countB);
+    for (int i = 0; i < 16; i++) {
+        fprintf(pFile, ";");
+    }
+    fprintf(pFile, "%s\n", result);
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage: rtperflog-compare [-t percent] [-a alpha] [-o result.csv] <baseline> <candidate>\n"
+            "  Compares the spans of two captures (CSV export or binary capture) by tag pair name.\n"
+            "  -t  Regression threshold of the median and p99 increase in percent (default 5)\n"
+            "  -a  Significance level of the Mann-Whitney U test and of the delta confidence intervals (default 0.01)\n"
+            "  -o  Write the comparison to a CSV file\n"
+            "  Pairs without spans in the candidate are MISSING, pairs with spans only in the candidate NEW.\n"
+            "  Neither is a regression.\n"
+            "  Exit code: 0=no regression;1=regression;2=error\n");
+}
+
+int main(int argc, char **argv) {
+    double threshold = 5.0;
+    double alpha = 0.01;
+    const char *outName = NULL;
+    const char *files[2] = {NULL, NULL};
+    int fileCount = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            alpha = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outName = argv[++i];
+        } else if (argv[i][0] != '-' && fileCount < 2) {
+            files[fileCount++] = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (fileCount != 2) {
+        usage();
+        return 2;
+    }
+    compare_run_t base = {NULL, 0};
+    compare_run_t cand = {NULL, 0};
+    if (loadRun(files[0], &base) != 0 || loadRun(files[1], &cand) != 0) {
+        freeRun(&base);
+        freeRun(&cand);
+        return 2;
+    }
+    FILE *pFile = NULL;
+    if (outName != NULL) {
+        pFile = fopen(outName, "w");
+        if (!pFile) {
+            fprintf(stderr, "[Error] Could not open %s: %s\n", outName, strerror(errno));
+            freeRun(&base);
+            freeRun(&cand);
+            return 2;
+        }
+        fprintf(pFile,
+                "TAGS;COUNT_A;COUNT_B;MEDIAN_A;MEDIAN_B;MEDIAN_DELTA;MEDIAN_DELTA_PCT;MEDIAN_CI_LOW;MEDIAN_CI_HIGH;"
+                "P99_A;P99_B;P99_DELTA;P99_DELTA_PCT;P99_CI_LOW;P99_CI_HIGH;MAX_A;MAX_B;MAX_DELTA;P_VALUE;RESULT\n");
+    }
+
+    int regressions = 0;
+    for (int c = 0; c < base.count; c++) {
+        compare_pair_t *a = &base.pairs[c];
+        int idx = findPair(&cand, a->name, 0);
+        long countB = idx < 0 ? 0 : cand.pairs[idx].count;
+        if (a->count == 0 || countB == 0) {
+            // Pairs with spans only in the candidate are reported below
+            if (a->count > 0) {
+                printf("%s | Count:%ld/0 missing in the candidate\n", a->name, a->count);
+                writeUnmatched(pFile, a->name, a->count, 0, "MISSING");
+            }
+            continue;
+        }
+        compare_pair_t *b = &cand.pairs[idx];
+        double medA = stats_quantile(a->samples, a->count, 0.5);
+        double medB = stats_quantile(b->samples, b->count, 0.5);
+        double p99A = stats_quantile(a->samples, a->count, 0.99);
+        double p99B = stats_quantile(b->samples, b->count, 0.99);
+        double maxA = a->samples[a->count - 1];
+        double maxB = b->samples[b->count - 1];
+        double pValue = stats_mannWhitney(a->samples, a->count, b->samples, b->count);
+        double medLow, medHigh, p99Low, p99High;
+        stats_quantileDeltaCI(a->samples, a->count, b->samples, b->count, 0.5, 1.0 - alpha, &medLow, &medHigh);
+        stats_quantileDeltaCI(a->samples, a->count, b->samples, b->count, 0.99, 1.0 - alpha, &p99Low, &p99High);
+
+        double medDelta = medB - medA;
+        double p99Delta = p99B - p99A;
+        double medPct = medA > 0.0 ? medDelta / medA * 100.0 : 0.0;
+        double p99Pct = p99A > 0.0 ? p99Delta / p99A * 100.0 : 0.0;
+
+        // The Mann-Whitney U test compares the whole distributions, so it is only used for the median. A p99 increase
+        // is significant at the level alpha when the 1 - alpha interval of its delta lies above zero.
+        int regression = (medPct > threshold && pValue < alpha && medLow > 0.0) || (p99Pct > threshold && p99Low > 0.0);
+        regressions += regression;
+        const char *result = regression ? "REGRESSION" : "OK";
+
+        printf("%s | Count:%ld/%ld Median:%.5fms->%.5fms (%+.2f%% CI:[%.5f,%.5f]) P99:%.5fms->%.5fms (%+.2f%% "
+               "CI:[%.5f,%.5f]) Max:%.5fms->%.5fms p:%.3g %s\n",
+               a->name, a->count, b->count, medA, medB, medPct, medLow, medHigh, p99A, p99B, p99Pct, p99Low, p99High,
+               maxA, maxB, pValue, result);
+        if (pFile != NULL) {
+            fprintf(pFile,
+                    "%s;%ld;%ld;%.10f;%.10f;%.10f;%.5f;%.10f;%.10f;%.10f;%.10f;%.10f;%.5f;%.10f;%.10f;%.10f;%.10f;"
+                    "%.10f;%g;%s\n",
+                    a->name, a->count, b->count, medA, medB, medDelta, medPct, medLow, medHigh, p99A, p99B, p99Delta,
+                    p99Pct, p99Low, p99High, maxA, maxB, maxB - maxA, pValue, result);
+        }
+    }
+    for (int c = 0; c < cand.count; c++) {
+        compare_pair_t *b = &cand.pairs[c];
+        int idx = findPair(&base, b->name, 0);
+        if (b->count > 0 && (idx < 0 || base.pairs[idx].count == 0)) {
+            printf("%s | Count:0/%ld only in the candidate\n", b->name, b->count);
+            writeUnmatched(pFile, b->name, 0, b->count, "NEW");
+        }
+    }
+    if (pFile != NULL) fclose(pFile);
+    freeRun(&base);
+    freeRun(&cand);
+    return regressions > 0 ? 1 : 0;
+}
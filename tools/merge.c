@@ -0,0 +1,401 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains rtperflog-merge, which merges captures of several processes into one time-ordered
+ * capture.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture.h"
+#include "loggerFormat.h"
+
+// Maximum count of sorted runs that are merged at the same time. Every run is read by its own cursor with an open
+// file. More runs are merged in several passes over temporary captures.
+#define MERGE_MAX_RUNS 512
+
+/**
+ * A sequence of entries of one input with non-decreasing timestamps. A capture contains one run per list, since the
+ * lists are exported one after another.
+ */
+typedef struct {
+    int input;
+    int64_t pos;
+    int64_t count;
+} merge_run_t;
+
+typedef struct {
+    capture_t cap;
+    int64_t remaining;
+    capture_entry_t entry;
+    int listOffset;
+    // Tag of the cursor -> tag of the output
+    int *tagMap;
+    int tagMapSize;
+} merge_cursor_t;
+
+typedef struct {
+    merge_run_t *runs;
+    int runCount;
+    int64_t entryCount;
+    int64_t minTime;
+    int clockType;
+    // Tag names of the output
+    capture_t names;
+    // Inputs and temporary captures of the merge passes. The names of temporary captures are owned.
+    const char **files;
+    // 0=input;1=temporary capture;2=removed temporary capture
+    char *temporary;
+    int *listOffset;
+    int fileCount;
+} merge_plan_t;
+
+static int addInput(merge_plan_t *plan, const char *fileName, int temporary) {
+    plan->files = (const char **)realloc((void *)plan->files, sizeof(char *) * (plan->fileCount + 1));
+    plan->temporary = (char *)realloc(plan->temporary, (size_t)plan->fileCount + 1);
+    plan->listOffset = (int *)realloc(plan->listOffset, sizeof(int) * (plan->fileCount + 1));
+    plan->files[plan->fileCount] = fileName;
+    plan->temporary[plan->fileCount] = (char)temporary;
+    plan->listOffset[plan->fileCount] = 0;
+    return plan->fileCount++;
+}
+
+static void addRun(merge_plan_t *plan, int input, int64_t pos) {
+    plan->runs = (merge_run_t *)realloc(plan->runs, sizeof(merge_run_t) * (plan->runCount + 1));
+    plan->runs[plan->runCount].input = input;
+    plan->runs[plan->runCount].pos = pos;
+    plan->runs[plan->runCount].count = 0;
+    plan->runCount++;
+}
+
+// Reads an input once and splits it into sorted runs. Only the run boundaries are kept in memory.
+static int scanInput(merge_plan_t *plan, int input, int *listCount) {
+    capture_t cap;
+    const char **files = plan->files;
+    int ret = capture_open(&cap, files[input]);
+    if (ret != 0) {
+        return ret;
+    }
+    if (cap.clockType < 0) {
+        fprintf(stderr, "[Warning] %s has no metadata, its timestamps are relative\n", files[input]);
+    } else if (plan->clockType < 0) {
+        plan->clockType = cap.clockType;
+    } else if (plan->clockType != cap.clockType) {
+        fprintf(stderr, "[Warning] %s uses another clock, its timestamps are not comparable\n", files[input]);
+    }
+    capture_entry_t entry;
+    int64_t last = 0;
+    int maxList = 0;
+    int first = plan->runCount;
+    int64_t pos = capture_tell(&cap);
+    while ((ret = capture_next(&cap, &entry)) == 1) {
+        if (plan->runCount == first || entry.time < last) {
+            addRun(plan, input, pos);
+        }
+        plan->runs[plan->runCount - 1].count++;
+        plan->entryCount++;
+        if (entry.time < plan->minTime) {
+            plan->minTime = entry.time;
+        }
+        if (entry.list > maxList) {
+            maxList = entry.list;
+        }
+        last = entry.time;
+        pos = capture_tell(&cap);
+    }
+    for (int n = 0; n < cap.nameCount; n++) {
+        capture_internTag(&plan->names, cap.names[n]);
+    }
+    *listCount = maxList + 1;
+    capture_close(&cap);
+    return ret < 0 ? ret : 0;
+}
+
+static int openCursor(merge_cursor_t *cur, const merge_plan_t *plan, const merge_run_t *run) {
+    memset(cur, 0, sizeof(merge_cursor_t));
+    int ret = capture_open(&cur->cap, plan->files[run->input]);
+    if (ret != 0) {
+        return ret;
+    }
+    cur->remaining = run->count;
+    cur->listOffset = plan->listOffset[run->input];
+    return capture_seek(&cur->cap, run->pos);
+}
+
+// Reads the next entry of a cursor and maps it to the tags and lists of the output.
+static int advance(merge_cursor_t *cur, merge_plan_t *plan) {
+    if (cur->remaining <= 0) {
+        return 0;
+    }
+    int ret = capture_next(&cur->cap, &cur->entry);
+    if (ret != 1) {
+        return ret < 0 ? ret : -3;
+    }
+    cur->remaining--;
+    if (cur->entry.tag >= cur->tagMapSize) {
+        cur->tagMap = (int *)realloc(cur->tagMap, sizeof(int) * (cur->entry.tag + 1));
+        for (int i = cur->tagMapSize; i <= cur->entry.tag; i++) {
+            cur->tagMap[i] = -1;
+        }
+        cur->tagMapSize = cur->entry.tag + 1;
+    }
+    if (cur->tagMap[cur->entry.tag] < 0) {
+        cur->tagMap[cur->entry.tag] = capture_internTag(&plan->names, capture_tagName(&cur->cap, cur->entry.tag));
+    }
+    cur->entry.tag = cur->tagMap[cur->entry.tag];
+    cur->entry.list = cur->listOffset + cur->entry.list;
+    return 1;
+}
+
+static int before(const merge_cursor_t *cursors, int a, int b) {
+    if (cursors[a].entry.time != cursors[b].entry.time) {
+        return cursors[a].entry.time < cursors[b].entry.time;
+    }
+    return a < b;
+}
+
+static void siftDown(int *heap, int count, const merge_cursor_t *cursors, int i) {
+    for (;;) {
+        int smallest = i;
+        int l = 2 * i + 1;
+        int r = l + 1;
+        if (l < count && before(cursors, heap[l], heap[smallest])) smallest = l;
+        if (r < count && before(cursors, heap[r], heap[smallest])) smallest = r;
+        if (smallest == i) {
+            return;
+        }
+        int tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+static void writeHeader(FILE *pFile, int binary, const merge_plan_t *plan, int64_t entryCount, int64_t baseSec) {
+    if (!binary) {
+        fprintf(pFile, "#rtperflog;version=%d;clock=%d;base_sec=%lld\n", LOGGER_CSV_VERSION, plan->clockType,
+                (long long)baseSec);
+        return;
+    }
+    _logger_fileHeader_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LOGGER_FILE_MAGIC, sizeof(header.magic));
+    header.version = LOGGER_FILE_VERSION;
+    header.clockType = plan->clockType;
+    header.tagCount = plan->names.nameCount;
+    header.entryCount = entryCount;
+    fwrite(&header, sizeof(header), 1, pFile);
+    for (int n = 0; n < plan->names.nameCount; n++) {
+        _logger_fileTag_t tag;
+        memset(&tag, 0, sizeof(tag));
+        tag.tag = n;
+        strncpy(tag.info, plan->names.names[n], sizeof(tag.info) - 1);
+        fwrite(&tag, sizeof(tag), 1, pFile);
+    }
+}
+
+static void writeEntry(FILE *pFile, int binary, const merge_plan_t *plan, const capture_entry_t *entry,
+                       int64_t baseSec) {
+    if (binary) {
+        _logger_fileEntry_t rec;
+        rec.tag = entry->tag;
+        rec.list = entry->list;
+        rec.id = (uint64_t)entry->id;
+        rec.time = entry->time;
+        rec.cpu = entry->cpu;
+        rec.reserved = 0;
+        fwrite(&rec, sizeof(rec), 1, pFile);
+        return;
+    }
+    char time[32];
+    capture_formatTime(time, sizeof(time), entry->time - baseSec * 1000000000LL);
+    // The list column keeps the lists of the inputs apart, the CPU column is empty when it was not recorded
+    fprintf(pFile, "%s,%lu,%s,", capture_tagName(&plan->names, entry->tag), entry->id, time);
+    if (entry->cpu >= 0) {
+        fprintf(pFile, "%d", entry->cpu);
+    }
+    fprintf(pFile, ",%d\n", entry->list);
+}
+
+// Merges runs into one time-ordered output.
+static int mergeRuns(merge_plan_t *plan, const merge_run_t *runs, int runCount, FILE *pFile, int binary,
+                     int64_t entryCount, int64_t baseSec) {
+    merge_cursor_t *cursors = (merge_cursor_t *)calloc((size_t)runCount + 1, sizeof(merge_cursor_t));
+    int *heap = (int *)malloc(sizeof(int) * ((size_t)runCount + 1));
+    int heapCount = 0;
+    int ret = 0;
+    for (int r = 0; r < runCount && ret == 0; r++) {
+        ret = openCursor(&cursors[r], plan, &runs[r]);
+        if (ret == 0 && (ret = advance(&cursors[r], plan)) == 1) {
+            heap[heapCount++] = r;
+            ret = 0;
+        }
+    }
+    if (ret == 0) {
+        writeHeader(pFile, binary, plan, entryCount, baseSec);
+        for (int i = heapCount / 2 - 1; i >= 0; i--) {
+            siftDown(heap, heapCount, cursors, i);
+        }
+        while (heapCount > 0 && ret == 0) {
+            merge_cursor_t *cur = &cursors[heap[0]];
+            writeEntry(pFile, binary, plan, &cur->entry, baseSec);
+            ret = advance(cur, plan);
+            if (ret == 1) {
+                ret = 0;
+            } else if (ret == 0) {
+                capture_close(&cur->cap);
+                heap[0] = heap[--heapCount];
+            }
+            siftDown(heap, heapCount, cursors, 0);
+        }
+    }
+    for (int r = 0; r < runCount; r++) {
+        capture_close(&cursors[r].cap);
+        free(cursors[r].tagMap);
+    }
+    free(cursors);
+    free(heap);
+    return ret;
+}
+
+// Merges groups of MERGE_MAX_RUNS runs into temporary captures, which are the runs of the next pass. The entries of a
+// temporary capture already have the lists of the output. They are CSV exports, which keep tag names of any length.
+static int mergePass(merge_plan_t *plan, const char *outName, int64_t baseSec) {
+    int groupCount = (plan->runCount + MERGE_MAX_RUNS - 1) / MERGE_MAX_RUNS;
+    merge_run_t *groups = (merge_run_t *)malloc(sizeof(merge_run_t) * (size_t)groupCount);
+    int firstTemporary = plan->fileCount;
+    int ret = 0;
+    for (int g = 0; g < groupCount && ret == 0; g++) {
+        const merge_run_t *runs = plan->runs + g * MERGE_MAX_RUNS;
+        int runCount = plan->runCount - g * MERGE_MAX_RUNS;
+        if (runCount > MERGE_MAX_RUNS) {
+            runCount = MERGE_MAX_RUNS;
+        }
+        size_t nameSize = strlen(outName) + 32;
+        char *name = (char *)malloc(nameSize);
+        snprintf(name, nameSize, "%s.%d.tmp", outName, plan->fileCount);
+        groups[g].input = addInput(plan, name, 1);
+        groups[g].pos = 0;
+        groups[g].count = 0;
+        for (int r = 0; r < runCount; r++) {
+            groups[g].count += runs[r].count;
+        }
+        FILE *pFile = fopen(name, "w");
+        if (!pFile) {
+            fprintf(stderr, "[Error] Could not open %s: %s\n", name, strerror(errno));
+            ret = -2;
+            break;
+        }
+        ret = mergeRuns(plan, runs, runCount, pFile, 0, groups[g].count, baseSec);
+        fclose(pFile);
+    }
+    // The temporary captures of the previous pass are not needed anymore
+    for (int r = 0; r < plan->runCount; r++) {
+        int input = plan->runs[r].input;
+        if (input < firstTemporary && plan->temporary[input] == 1) {
+            remove(plan->files[input]);
+            plan->temporary[input] = 2;
+        }
+    }
+    free(plan->runs);
+    plan->runs = groups;
+    plan->runCount = groupCount;
+    return ret;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage: rtperflog-merge [-b] -o <output> <capture>...\n"
+            "  Merges captures (CSV export or binary capture) of several processes into one time-ordered capture.\n"
+            "  The lists of the inputs are numbered one after another in the output.\n"
+            "  -b  Write a binary capture instead of a CSV export\n"
+            "  -o  Output file\n");
+}
+
+int main(int argc, char **argv) {
+    int binary = 0;
+    const char *outName = NULL;
+    const char **files = (const char **)malloc(sizeof(char *) * (size_t)argc);
+    int fileCount = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0) {
+            binary = 1;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outName = argv[++i];
+        } else if (argv[i][0] != '-') {
+            files[fileCount++] = argv[i];
+        } else {
+            usage();
+            free(files);
+            return 2;
+        }
+    }
+    if (outName == NULL || fileCount == 0) {
+        usage();
+        free(files);
+        return 2;
+    }
+
+    merge_plan_t plan;
+    memset(&plan, 0, sizeof(plan));
+    plan.minTime = INT64_MAX;
+    plan.clockType = -1;
+    int ret = 0;
+    int lists = 0;
+    for (int f = 0; f < fileCount && ret == 0; f++) {
+        int listCount = 0;
+        int input = addInput(&plan, files[f], 0);
+        plan.listOffset[input] = lists;
+        ret = scanInput(&plan, input, &listCount);
+        lists += listCount;
+    }
+    int runCount = plan.runCount;
+    int64_t baseSec = plan.entryCount > 0 ? plan.minTime / 1000000000LL : 0;
+    if (plan.entryCount > 0 && plan.minTime < 0 && plan.minTime % 1000000000LL != 0) {
+        baseSec--;
+    }
+    while (ret == 0 && plan.runCount > MERGE_MAX_RUNS) {
+        ret = mergePass(&plan, outName, baseSec);
+    }
+    if (ret == 0) {
+        FILE *pFile = fopen(outName, binary ? "wb" : "w");
+        if (!pFile) {
+            fprintf(stderr, "[Error] Could not open %s: %s\n", outName, strerror(errno));
+            ret = -2;
+        } else {
+            ret = mergeRuns(&plan, plan.runs, plan.runCount, pFile, binary, plan.entryCount, baseSec);
+            fclose(pFile);
+        }
+    }
+    if (ret == 0) {
+        printf("Merged %lld entries of %d captures (%d runs) into %s\n", (long long)plan.entryCount, fileCount,
+               runCount, outName);
+    }
+    for (int f = 0; f < plan.fileCount; f++) {
+        if (plan.temporary[f]) {
+            if (plan.temporary[f] == 1) {
+                remove(plan.files[f]);
+            }
+            free((void *)plan.files[f]);
+        }
+    }
+    capture_close(&plan.names);
+    free(plan.runs);
+    free((void *)plan.files);
+    free(plan.temporary);
+    free(plan.listOffset);
+    free(files);
+    return ret == 0 ? 0 : 2;
+}
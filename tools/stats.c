@@ -0,0 +1,123 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains the statistics of rtperflog-compare.
+ */
+#include "stats.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "loggerUtil.h"
+
+double stats_quantile(const double *sorted, long n, double p) {
+    double rank = p * (double)(n - 1);
+    long lo = (long)floor(rank);
+    long hi = (long)ceil(rank);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - (double)lo);
+}
+
+double stats_mannWhitney(const double *a, long na, const double *b, long nb) {
+    double rankSumA = 0.0;
+    double tieSum = 0.0;
+    long i = 0;
+    long j = 0;
+    long rank = 1;
+    while (i < na || j < nb) {
+        double v = (j >= nb || (i < na && a[i] <= b[j])) ? a[i] : b[j];
+        long ca = 0;
+        long cb = 0;
+        while (i < na && a[i] == v) {
+            i++;
+            ca++;
+        }
+        while (j < nb && b[j] == v) {
+            j++;
+            cb++;
+        }
+        long t = ca + cb;
+        double midRank = (double)rank + (double)(t - 1) / 2.0;
+        rankSumA += midRank * (double)ca;
+        tieSum += (double)t * (double)t * (double)t - (double)t;
+        rank += t;
+    }
+    double n = (double)(na + nb);
+    double u = rankSumA - (double)na * ((double)na + 1.0) / 2.0;
+    double mean = (double)na * (double)nb / 2.0;
+    double var = (double)na * (double)nb / 12.0 * ((n + 1.0) - tieSum / (n * (n - 1.0)));
+    if (var <= 0.0) {
+        return 1.0;
+    }
+    double z = (u - mean) / sqrt(var);
+    return erfc(fabs(z) / sqrt(2.0));
+}
+
+// xorshift64* generator
+static double _stats_uniform(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return ((double)((*state * 0x2545F4914F6CDD1Dull) >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double _stats_normal(uint64_t *state) {
+    double u = _stats_uniform(state);
+    double v = _stats_uniform(state);
+    return sqrt(-2.0 * log(u)) * cos(6.283185307179586 * v);
+}
+
+// Gamma distribution with shape >= 1 by Marsaglia and Tsang
+static double _stats_gamma(uint64_t *state, double shape) {
+    double d = shape - 1.0 / 3.0;
+    double c = 1.0 / sqrt(9.0 * d);
+    for (;;) {
+        double x = _stats_normal(state);
+        double v = 1.0 + c * x;
+        if (v <= 0.0) {
+            continue;
+        }
+        v = v * v * v;
+        if (log(_stats_uniform(state)) < 0.5 * x * x + d - d * v + d * log(v)) {
+            return d * v;
+        }
+    }
+}
+
+// Order statistic of rank k (1-based) of a resample of n sorted samples
+static double _stats_resampleQuantile(uint64_t *state, const double *sorted, long n, long k) {
+    double x = _stats_gamma(state, (double)k);
+    double y = _stats_gamma(state, (double)(n + 1 - k));
+    long idx = (long)floor((double)n * x / (x + y));
+    return sorted[idx < 0 ? 0 : idx > n - 1 ? n - 1 : idx];
+}
+
+void stats_quantileDeltaCI(const double *a, long na, const double *b, long nb, double p, double level, double *low,
+                           double *high) {
+    long ka = (long)ceil(p * (double)na);
+    long kb = (long)ceil(p * (double)nb);
+    ka = ka < 1 ? 1 : ka;
+    kb = kb < 1 ? 1 : kb;
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    double *deltas = (double *)malloc(sizeof(double) * STATS_BOOTSTRAP);
+    for (int r = 0; r < STATS_BOOTSTRAP; r++) {
+        deltas[r] = _stats_resampleQuantile(&state, b, nb, kb) - _stats_resampleQuantile(&state, a, na, ka);
+    }
+    qsort(deltas, STATS_BOOTSTRAP, sizeof(double), _logger_compareDouble);
+    // 0-based indexes of the (1 - level) / 2 and (1 + level) / 2 quantiles of the replicates
+    long lo = (long)floor((1.0 - level) / 2.0 * STATS_BOOTSTRAP);
+    long hi = (long)ceil((1.0 + level) / 2.0 * STATS_BOOTSTRAP) - 1;
+    *low = deltas[lo < 0 ? 0 : lo];
+    *high = deltas[hi > STATS_BOOTSTRAP - 1 ? STATS_BOOTSTRAP - 1 : hi];
+    free(deltas);
+}
@@ -0,0 +1,47 @@
+/**
+ * @copyright: (c) 2019-2022, Institute for Control Engineering of Machine Tools and Manufacturing Units,
+ *             University of Stuttgart
+ *             All rights reserved. Licensed under the Apache License, Version 2.0 (the "License");
+ *             you may not use this file except in compliance with the License.
+ *             You may obtain a copy of the License at
+ *                  http://www.apache.org/licenses/LICENSE-2.0
+ *             Unless required by applicable law or agreed to in writing, software
+ *             distributed under the License is distributed on an "AS IS" BASIS,
+ *             WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *             See the License for the specific language governing permissions and
+ *             limitations under the License.
+ * @author: Marc Fischer <marc.fischer@isw.uni-stuttgart.de>
+ * @description: This file contains the statistics of rtperflog-compare.
+ */
+
+#ifndef RTPERFLOG_STATS_H
+#define RTPERFLOG_STATS_H
+
+// Count of bootstrap replicates of `stats_quantileDeltaCI`
+#define STATS_BOOTSTRAP 2000
+
+/**
+ * Returns the quantile p of sorted samples. It is interpolated between the two nearest order statistics.
+ */
+double stats_quantile(const double *sorted, long n, double p);
+
+/**
+ * Returns the two-sided p-value of the Mann-Whitney U test of two sorted samples. It uses the normal approximation
+ * with tie correction.
+ */
+double stats_mannWhitney(const double *a, long na, const double *b, long nb);
+
+/**
+ * Computes a confidence interval of the difference of the quantile p of b and of a by a percentile bootstrap. The
+ * quantile of a resample is its order statistic of rank ceil(n * p). It is drawn directly: the rank k order statistic
+ * of n uniform values is Beta(k, n + 1 - k) distributed, so one replicate costs O(1) instead of a resample of n
+ * values. The random numbers have a fixed seed, so the result is reproducible.
+ *
+ * @param a Sorted samples of the baseline.
+ * @param b Sorted samples of the candidate.
+ * @param level The confidence level, e.g. 0.99.
+ */
+void stats_quantileDeltaCI(const double *a, long na, const double *b, long nb, double p, double level, double *low,
+                           double *high);
+
+#endif  // RTPERFLOG_STATS_H